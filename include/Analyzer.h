@@ -0,0 +1,64 @@
+#pragma once
+#include "board.h"
+#include "Search.h"
+#include "SpscQueue.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+
+// One progress report of a background analysis.
+struct AnalysisUpdate {
+    static constexpr int MAX_PV = 8;
+
+    uint64_t key = 0; // position analysed, to drop reports that arrive after it changed
+    int depth = 0;
+    int score = 0;    // side to move's point of view
+    uint64_t nodes = 0;
+    int pvLength = 0;
+    Move pv[MAX_PV];
+};
+
+// Infinite analysis on a background thread for an interactive front end. All public methods
+// are meant for one (UI) thread and never wait for the engine: positions are handed over and
+// reports are collected through lock-free single-producer queues.
+class Analyzer {
+public:
+    explicit Analyzer(size_t hashMB = 64, int threads = 1);
+    ~Analyzer();
+
+    Analyzer(const Analyzer&) = delete;
+    Analyzer& operator=(const Analyzer&) = delete;
+
+    // Analyse `board` from now on, abandoning the previous position.
+    void analyze(const Board& board);
+    // Stop analysing until the next analyze().
+    void pause();
+    // Take the next report, if there is one.
+    bool poll(AnalysisUpdate& update);
+
+private:
+    struct Request {
+        bool active = false;
+        Board board;
+    };
+
+    void submit(Request request);
+    void threadMain();
+
+    TranspositionTable tt_;
+    Search search_;
+
+    SpscQueue<Request, 8> requests_;
+    SpscQueue<AnalysisUpdate, 64> updates_;
+    // A request that did not fit in the queue yet; retried by the next call.
+    std::optional<Request> pending_;
+    // Bumped after each request so the analysis thread can sleep until there is one.
+    std::atomic<uint32_t> requestCount_{0};
+    std::atomic<bool> quit_{false};
+    // Key of the position being searched, stamped on its reports.
+    std::atomic<uint64_t> currentKey_{0};
+    std::thread thread_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include "board.h"
+#include "Nnue.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+enum class BatchStatus : uint8_t { Normal, Check, Checkmate, Stalemate, Invalid = 255 };
+
+// What is known about one input position. Also the record of the binary output format: the
+// fields in this order, little endian, 16 bytes per position.
+struct BatchResult {
+    uint64_t line = 0;      // 1-based line of the input
+    int16_t eval = 0;       // static evaluation, side to move's point of view
+    int16_t score = 0;      // search score, side to move's point of view; 0 without a search
+    uint16_t bestMove = 0;  // Move::raw() of the search's move; 0 without a search
+    uint8_t legalMoves = 0;
+    BatchStatus status = BatchStatus::Invalid;
+};
+static_assert(sizeof(BatchResult) == 16, "BatchResult is a file format");
+
+enum class BatchFormat { Csv, Binary };
+
+struct BatchOptions {
+    int threads = 1;
+    // Fixed-depth search per position; 0 for none.
+    int depth = 0;
+    // Transposition table of each thread's search.
+    size_t hashMB = 16;
+    BatchFormat format = BatchFormat::Csv;
+    // Evaluate with this network instead of evaluate() when not null.
+    const Nnue::Network* network = nullptr;
+    // Input is split into pieces of about this size, cut at line ends, and handed to threads.
+    size_t chunkBytes = 1 << 20;
+};
+
+struct BatchStats {
+    uint64_t positions = 0;
+    uint64_t invalid = 0;
+    double seconds = 0;
+};
+
+// Analyse every record of `text` (EPD or FEN, one per line) on options.threads threads and write
+// one result per record to `out`, in input order: CSV with a header line, or BatchResult
+// records. Each thread reuses one Board and, when searching, one Search for all its positions.
+BatchStats analyzeBatch(std::string_view text, const BatchOptions& options, std::ostream& out);
@@ -0,0 +1,177 @@
+#pragma once
+#include "Piece.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+
+// Slider lookups index their tables with BMI2 PEXT when the build targets it (CHESS_PEXT in CMake,
+// or any -march that implies BMI2); otherwise fancy magic multiplication is used.
+#if defined(__BMI2__) && !defined(CHESS_NO_PEXT)
+#include <immintrin.h>
+#define CHESS_USE_PEXT 1
+#endif
+
+// A set of squares, one bit per square. Bit 0 is a1, bit 7 is h1, bit 63 is h8.
+using Bitboard = uint64_t;
+
+// Square index 0..63 in the same a1 = 0 layout, or NO_SQUARE.
+using Square = int;
+constexpr Square NO_SQUARE = 64;
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr Bitboard RANK_1_BB = 0xFFULL;
+constexpr Bitboard RANK_2_BB = RANK_1_BB << 8;
+constexpr Bitboard RANK_3_BB = RANK_1_BB << 16;
+constexpr Bitboard RANK_6_BB = RANK_1_BB << 40;
+constexpr Bitboard RANK_7_BB = RANK_1_BB << 48;
+constexpr Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+// Board rows count from the top (row 0 is rank 8) to match Position.
+constexpr Square makeSquare(int row, int col) { return (7 - row) * 8 + col; }
+inline Square toSquare(const Position& p) { return makeSquare(p.row, p.col); }
+inline Position toPosition(Square sq) { return Position(7 - (sq >> 3), sq & 7); }
+
+constexpr int fileOf(Square sq) { return sq & 7; }
+constexpr int rankOf(Square sq) { return sq >> 3; }
+
+constexpr Bitboard squareBB(Square sq) { return 1ULL << sq; }
+constexpr Bitboard fileBB(Square sq) { return FILE_A_BB << fileOf(sq); }
+constexpr Bitboard rankBB(Square sq) { return RANK_1_BB << (8 * rankOf(sq)); }
+
+inline int popcount(Bitboard b) { return std::popcount(b); }
+inline Square lsb(Bitboard b) { return std::countr_zero(b); }
+
+// Return the lowest set square and clear it from the set.
+inline Square popLsb(Bitboard& b) {
+    Square sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+inline bool moreThanOne(Bitboard b) { return b & (b - 1); }
+
+// `b` moved one step in direction D (north 8, south -8, and the four diagonals 7, 9, -7, -9);
+// squares that would wrap around the a- or h-file fall off.
+template <int D>
+constexpr Bitboard shift(Bitboard b) {
+    static_assert(D == 8 || D == -8 || D == 7 || D == 9 || D == -7 || D == -9);
+    if constexpr (D == 8) return b << 8;
+    else if constexpr (D == -8) return b >> 8;
+    else if constexpr (D == 9) return (b & ~FILE_H_BB) << 9;
+    else if constexpr (D == 7) return (b & ~FILE_A_BB) << 7;
+    else if constexpr (D == -7) return (b & ~FILE_H_BB) >> 7;
+    else return (b & ~FILE_A_BB) >> 9;
+}
+
+namespace Bitboards {
+
+// Builders for the step and line tables below, run by the compiler. The bounds checks live
+// here so lookups need none.
+constexpr Bitboard stepAttacks(Square sq, const int (&steps)[8][2], int count) {
+    Bitboard b = 0;
+    for (int i = 0; i < count; i++) {
+        int r = rankOf(sq) + steps[i][0];
+        int f = fileOf(sq) + steps[i][1];
+        if (r >= 0 && r < 8 && f >= 0 && f < 8) b |= squareBB(r * 8 + f);
+    }
+    return b;
+}
+
+constexpr std::array<Bitboard, 64> stepTable(const int (&steps)[8][2], int count) {
+    std::array<Bitboard, 64> table{};
+    for (Square sq = 0; sq < 64; sq++) table[sq] = stepAttacks(sq, steps, count);
+    return table;
+}
+
+constexpr int KNIGHT_STEPS[8][2] = {{-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {-2, -1}, {-2, 1}, {2, -1}, {2, 1}};
+constexpr int KING_STEPS[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+constexpr int PAWN_STEPS[2][8][2] = {{{1, -1}, {1, 1}}, {{-1, -1}, {-1, 1}}};
+
+// Walk from `a` in every queen direction; if `b` is met, fill in the squares passed on the way
+// (between) or the whole line through both (line).
+constexpr std::array<std::array<Bitboard, 64>, 64> lineTable(bool between) {
+    std::array<std::array<Bitboard, 64>, 64> table{};
+    for (Square a = 0; a < 64; a++) {
+        for (const auto& d : KING_STEPS) {
+            Bitboard ray = 0, back = 0;
+            for (int r = rankOf(a) - d[0], f = fileOf(a) - d[1]; r >= 0 && r < 8 && f >= 0 && f < 8; r -= d[0], f -= d[1])
+                back |= squareBB(r * 8 + f);
+            for (int r = rankOf(a) + d[0], f = fileOf(a) + d[1]; r >= 0 && r < 8 && f >= 0 && f < 8; r += d[0], f += d[1])
+                ray |= squareBB(r * 8 + f);
+            Bitboard passed = 0;
+            for (int r = rankOf(a) + d[0], f = fileOf(a) + d[1]; r >= 0 && r < 8 && f >= 0 && f < 8; r += d[0], f += d[1]) {
+                table[a][r * 8 + f] = between ? passed : (back | squareBB(a) | ray);
+                passed |= squareBB(r * 8 + f);
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr std::array<Bitboard, 64> KnightAttacks = stepTable(KNIGHT_STEPS, 8);
+inline constexpr std::array<Bitboard, 64> KingAttacks = stepTable(KING_STEPS, 8);
+// PawnAttacks[0] for white, [1] for black.
+inline constexpr std::array<std::array<Bitboard, 64>, 2> PawnAttacks = {stepTable(PAWN_STEPS[0], 2), stepTable(PAWN_STEPS[1], 2)};
+// Squares strictly between two squares on a shared rank, file or diagonal; empty otherwise.
+inline constexpr std::array<std::array<Bitboard, 64>, 64> BetweenBB = lineTable(true);
+// The full rank, file or diagonal through two aligned squares; empty otherwise.
+inline constexpr std::array<std::array<Bitboard, 64>, 64> LineBB = lineTable(false);
+
+// Slider attack table entry for one square. The relevant occupancy (mask bits) is mapped to a
+// dense index into `attacks`, which points into one shared table per piece type.
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#ifdef CHESS_USE_PEXT
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic BishopMagics[64];
+extern Magic RookMagics[64];
+
+// Fill the slider tables. Called once from a static initializer in bitboard.cpp; the step and
+// line tables are built at compile time.
+void init();
+
+inline Bitboard bishopAttacks(Square sq, Bitboard occupied) {
+    const Magic& m = BishopMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(Square sq, Bitboard occupied) {
+    const Magic& m = RookMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(Square sq, Bitboard occupied) {
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+inline Bitboard pawnAttacks(PieceColor c, Square sq) {
+    return PawnAttacks[c == PieceColor::White ? 0 : 1][sq];
+}
+
+// Attacks of a non-pawn piece type, the type known at compile time.
+template <PieceType Pt>
+inline Bitboard attacks(Square sq, Bitboard occupied) {
+    if constexpr (Pt == PieceType::Knight) return KnightAttacks[sq];
+    else if constexpr (Pt == PieceType::Bishop) return bishopAttacks(sq, occupied);
+    else if constexpr (Pt == PieceType::Rook) return rookAttacks(sq, occupied);
+    else if constexpr (Pt == PieceType::Queen) return queenAttacks(sq, occupied);
+    else return KingAttacks[sq];
+}
+
+inline bool aligned(Square a, Square b, Square c) {
+    return LineBB[a][b] & squareBB(c);
+}
+
+} // namespace Bitboards
@@ -0,0 +1,64 @@
+#pragma once
+#include "board.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// One EPD operation: an opcode and its operands, e.g. `bm Nf3 e4;` or `id "WAC.001";`.
+// Operands are the raw text up to the terminating ';' with surrounding blanks removed, so
+// quoted strings keep their quotes.
+struct EpdOperation {
+    std::string_view opcode;
+    std::string_view operands;
+};
+
+// One record of an EPD file. The views point into the reader's buffer and stay valid as long
+// as the reader does.
+struct EpdEntry {
+    static constexpr int MAX_OPERATIONS = 32;
+
+    Board board;
+    std::string_view line;
+    size_t lineNumber = 0;
+    // Set when the position could not be read; board and operations are then not valid.
+    // error.offset is relative to `line`.
+    FenError error;
+    int operationCount = 0;
+    EpdOperation operations[MAX_OPERATIONS];
+
+    // The operation with this opcode, or nullptr.
+    const EpdOperation* find(std::string_view opcode) const;
+    // Operands of `opcode` read as an integer, e.g. the node count of perft suites' `D5 4865609`.
+    bool integer(std::string_view opcode, uint64_t& value) const;
+};
+
+// Streams the records of an EPD file, one line each: the first four FEN fields, optionally the
+// two move counters, then operations separated by ';'. Blank lines and lines starting with '#'
+// are skipped. Records are parsed straight out of a memory-mapped file without allocating.
+class EpdReader {
+public:
+    EpdReader() = default;
+    // Read records from text owned by the caller.
+    explicit EpdReader(std::string_view text) : text_(text) {}
+
+    // Map `path` and read records from it. On failure returns false and sets `error`.
+    bool open(const std::string& path, std::string& error);
+
+    // Parse the next record into `entry`; false at the end of the input. A record that fails
+    // to parse is still returned, with entry.error set.
+    bool next(EpdEntry& entry);
+
+    // Bytes consumed so far and in total, for progress reports.
+    size_t position() const { return pos_; }
+    size_t size() const { return text_.size(); }
+    // Lines read so far, including skipped ones.
+    size_t lineNumber() const { return lineNumber_; }
+
+private:
+    MappedFile file_;
+    std::string_view text_;
+    size_t pos_ = 0;
+    size_t lineNumber_ = 0;
+};
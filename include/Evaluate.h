@@ -0,0 +1,21 @@
+#pragma once
+#include "board.h"
+
+constexpr int PAWN_VALUE = 100;
+constexpr int KNIGHT_VALUE = 320;
+constexpr int BISHOP_VALUE = 330;
+constexpr int ROOK_VALUE = 500;
+constexpr int QUEEN_VALUE = 900;
+
+// Material value by PieceType (kings are not counted).
+constexpr int PIECE_VALUES[7] = {0, PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, 0};
+
+// Static evaluation in centipawns from the side to move's point of view: the incrementally
+// maintained material and piece-square score, blended from its middlegame to its endgame value
+// by game phase. Constant time.
+int evaluate(const Board& board);
+
+// Recompute Board::psqScore() and Board::gamePhase() from the piece placement and compare them
+// with the incremental values. Slow; evaluate() calls it on every node and aborts on a mismatch
+// when built with CHESS_CHECK_EVAL.
+bool verifyEvalTerms(const Board& board);
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// A whole file mapped read-only into memory. Pages are read in by the OS as they are touched,
+// so a multi-gigabyte file opens instantly and is never copied. Move-only.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map `path`, unmapping any previous file. On failure returns false, sets `error` and
+    // leaves the object empty.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    // Hint that the file will be read front to back.
+    void adviseSequential() const;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+    bool isOpen() const { return open_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    // An empty file maps nothing but is still open.
+    bool open_ = false;
+};
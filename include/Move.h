@@ -0,0 +1,102 @@
+#pragma once
+#include "Piece.h"
+#include "Bitboard.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A move packed into 16 bits: bits 0-5 from square, bits 6-11 to square, bits 12-15 flags.
+// The flag values follow the usual from-to-flags layout: bit 2 marks captures, bit 3 marks
+// promotions and the low two bits of a promotion pick the piece (knight, bishop, rook, queen).
+class Move {
+public:
+    enum Flag : uint8_t {
+        Quiet = 0,
+        DoublePush = 1,
+        KingCastle = 2,
+        QueenCastle = 3,
+        Capture = 4,
+        EnPassant = 5,
+        PromotionFlag = 8,
+        PromotionCaptureFlag = 12
+    };
+
+    // Left uninitialized so MoveList storage costs nothing to create; use Move{} for a null move.
+    constexpr Move() = default;
+    constexpr Move(Square from, Square to, unsigned flags = Quiet)
+        : data_(static_cast<uint16_t>(from | (to << 6) | (flags << 12))) {}
+
+    static constexpr Move fromRaw(uint16_t raw) { Move m{}; m.data_ = raw; return m; }
+    constexpr uint16_t raw() const { return data_; }
+
+    constexpr Square from() const { return data_ & 63; }
+    constexpr Square to() const { return (data_ >> 6) & 63; }
+    constexpr unsigned flags() const { return data_ >> 12; }
+
+    constexpr bool isNull() const { return data_ == 0; }
+    constexpr bool isCapture() const { return flags() & Capture; }
+    constexpr bool isEnpassant() const { return flags() == EnPassant; }
+    constexpr bool isCastling() const { return flags() == KingCastle || flags() == QueenCastle; }
+    constexpr bool isPromotion() const { return flags() & PromotionFlag; }
+
+    constexpr Promotion promotion() const {
+        return isPromotion() ? static_cast<Promotion>((flags() & 3) + 1) : Promotion::None;
+    }
+    constexpr PieceType promotionType() const {
+        return isPromotion() ? static_cast<PieceType>((flags() & 3) + static_cast<int>(PieceType::Knight))
+                             : PieceType::None;
+    }
+
+    constexpr bool operator==(const Move& other) const { return data_ == other.data_; }
+    constexpr bool operator!=(const Move& other) const { return data_ != other.data_; }
+
+private:
+    uint16_t data_;
+};
+
+// Promotion flag for a promotion to `p`, optionally capturing.
+constexpr unsigned promotionFlags(Promotion p, bool isCapture) {
+    return (isCapture ? Move::PromotionCaptureFlag : Move::PromotionFlag) | (static_cast<unsigned>(p) - 1);
+}
+
+// Coordinate notation as used by UCI, e.g. "e2e4" or "e7e8q".
+inline std::string toUci(Move m) {
+    std::string s;
+    s += static_cast<char>('a' + fileOf(m.from()));
+    s += static_cast<char>('1' + rankOf(m.from()));
+    s += static_cast<char>('a' + fileOf(m.to()));
+    s += static_cast<char>('1' + rankOf(m.to()));
+    if (m.isPromotion()) s += "nbrq"[static_cast<int>(m.promotion()) - 1];
+    return s;
+}
+
+// Enough for any legal chess position (the known maximum is 218).
+constexpr size_t MAX_MOVES = 256;
+
+// Fixed-capacity move list with inline storage, so generation never touches the heap.
+class MoveList {
+public:
+    void push_back(Move m) { moves_[size_++] = m; }
+    void clear() { size_ = 0; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    Move& operator[](size_t i) { return moves_[i]; }
+    const Move& operator[](size_t i) const { return moves_[i]; }
+
+    Move* begin() { return moves_; }
+    Move* end() { return moves_ + size_; }
+    const Move* begin() const { return moves_; }
+    const Move* end() const { return moves_ + size_; }
+
+    bool contains(Move m) const {
+        for (Move x : *this)
+            if (x == m) return true;
+        return false;
+    }
+
+private:
+    Move moves_[MAX_MOVES];
+    size_t size_ = 0;
+};
@@ -1,322 +1,302 @@
 #pragma once
 #include "board.h"
-#include <vector>
+#include "Move.h"
 
+// Which part of the legal moves to generate. Captures and Quiets split All in two: Captures
+// holds the captures (en passant included) and the queen promotions, Quiets everything else,
+// underpromotions and castling included.
+enum class GenType { All, Captures, Quiets };
+
+// Legal move generation. Checkers and pinned pieces are computed once per call so every emitted
+// move is legal without making it: in check only evasions are produced, pinned pieces stay on
+// the line to their king, and en-passant is verified against discovered checks.
 class MoveGenerator {
 public:
-    static void generateAll(const Board& board, std::vector<Move>& out) {
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                Position pos(r, c);
-                generateFrom(board, pos, out);
-            }
-        }
+    // Legal moves for the side to move.
+    static void generateAll(const Board& board, MoveList& out) {
+        generate(board, ~0ULL, GenType::All, out);
     }
 
-    static void generateAllSide(const Board& board, PieceColor side, std::vector<Move>& out) {
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                Position pos(r, c);
-                const Piece* p = board.getPiece(pos);
-                if (p && p->color() != side) continue;
-                generateFrom(board, pos, out);
-            }
-        }
+    // The legal captures and queen promotions, for ordering and the quiescence search.
+    static void generateCaptures(const Board& board, MoveList& out) {
+        generate(board, ~0ULL, GenType::Captures, out);
     }
 
-    static void generateFrom(const Board& board, const Position& from, std::vector<Move>& out) {
-        const Piece* p = board.getPiece(from);
-        if (!p) return;
-        switch (p->type()) {
-        case PieceType::Pawn:   add_pawnMoves(board, from, out); break;
-        case PieceType::Knight: add_knightMoves(board, from, out); break;
-        case PieceType::Bishop: add_bishopMoves(board, from, out); break;
-        case PieceType::Rook:   add_rookMoves(board, from, out); break;
-        case PieceType::Queen:  add_queenMoves(board, from, out); break;
-        case PieceType::King:   add_kingMoves(board, from, out); break;
-        default: break;
-        }
+    // The remaining legal moves.
+    static void generateQuiets(const Board& board, MoveList& out) {
+        generate(board, ~0ULL, GenType::Quiets, out);
+    }
+
+    // Legal moves of the piece on `from`; nothing if it does not belong to the side to move.
+    static void generateFrom(const Board& board, const Position& from, MoveList& out) {
+        if (!board.inBounds(from)) return;
+        generate(board, squareBB(toSquare(from)), GenType::All, out);
+    }
+
+    // Whether the side to move has any legal move, without generating them: stops at the first
+    // one found, cheapest pieces to test first. Castling is never needed, since it is only legal
+    // when the king could step to the square next to it anyway.
+    static bool hasLegalMove(const Board& board) {
+        return board.getTurn() == PieceColor::White ? hasLegalMove<PieceColor::White>(board)
+                                                    : hasLegalMove<PieceColor::Black>(board);
     }
 
 private:
-    static void add_pawnMoves(const Board& board, const Position& from, std::vector<Move>& out) {
-        const Piece* me = board.getPiece(from);
-        if (!me || me->type() != PieceType::Pawn) return;
-
-        const int dir = (me->color() == PieceColor::White) ? -1 : 1;
-        const int startRow = (me->color() == PieceColor::White) ? 6 : 1;
-        const int promoteRow = (me->color() == PieceColor::White) ? 0 : 7;
-        Position one { from.row + dir, from.col };
-        if (board.inBounds(one) && board.getPiece(one) == nullptr) {
-            if (one.row == promoteRow) {
-                for (Promotion pr : {Promotion::Queen, Promotion::Rook, Promotion::Knight, Promotion::Bishop }) {
-                    Move m{from, one};
-                    m.promotion = pr;
-                    m.isCapture = false;
-                    m.isEnpassant = false;
-                    m.isCastling = false;
-                    out.push_back(m);
-                }
-            } else {
-                Move m{from, one};
-                m.promotion = Promotion::None;
-                m.isCapture = false;
-                m.isEnpassant = false;
-                m.isCastling = false;
-                out.push_back(m);
-
-                Position two{ from.row + 2*dir, from.col };
-                if (from.row == startRow && board.inBounds(two) && board.getPiece(two) == nullptr) {
-                    Move m2{from, two};
-                    m2.promotion = Promotion::None;
-                    m2.isCapture = false;
-                    m2.isEnpassant = false; // this is set when the move is applied
-                    m2.isCastling = false;
-                    out.push_back(m2);
-                }
-            }
+    template <PieceColor Us>
+    static bool hasLegalMove(const Board& board) {
+        constexpr PieceColor Them = opposite(Us);
+        constexpr int Up = Us == PieceColor::White ? 8 : -8;
+        constexpr int UpLeft = Us == PieceColor::White ? 7 : -9;
+        constexpr int UpRight = Us == PieceColor::White ? 9 : -7;
+        constexpr Bitboard Rank3 = Us == PieceColor::White ? RANK_3_BB : RANK_6_BB;
+        const Square king = board.kingSquare(Us);
+        if (king == NO_SQUARE) return false;
+
+        const Bitboard occupied = board.occupied();
+        const Bitboard own = board.pieces(Us);
+        const Bitboard checkers = board.attackersTo(king, Them);
+
+        Bitboard targets = Bitboards::KingAttacks[king] & ~own;
+        while (targets) {
+            if (!(board.attackersTo(popLsb(targets), occupied ^ squareBB(king)) & board.pieces(Them))) return true;
         }
+        if (moreThanOne(checkers)) return false;
 
-        Position enPass = board.enPassantTarget();
-        for (int dc : {-1, 1}) {
-            Position cap{ from.row + dir, from.col + dc};
-            if (!board.inBounds(cap)) continue;
-            const Piece* target = board.getPiece(cap);
-            if (target && target->color() != me->color()) {
-                if (cap.row == promoteRow) {
-                    for (Promotion pr : { Promotion::Queen, Promotion::Rook, Promotion::Bishop, Promotion::Knight }) {
-                        Move m{from, cap};
-                        m.promotion = pr;
-                        m.isCapture = true;
-                        m.isEnpassant = false;
-                        m.isCastling = false;
-                        out.push_back(m);
-                    }
-                } else {
-                    Move m{from, cap};
-                    m.promotion = Promotion::None;
-                    m.isCapture = true;
-                    m.isEnpassant = false;
-                    m.isCastling = false;
-                    out.push_back(m);
-                }
+        const Bitboard target = checkers ? (Bitboards::BetweenBB[king][lsb(checkers)] | checkers) : ~own;
+        const Bitboard pinned = board.blockersForKing(Us) & own;
+
+        // Unpinned pieces: any target will do.
+        const Bitboard free = own & ~pinned;
+        const Bitboard empty = ~occupied;
+        const Bitboard pawns = free & board.pieces(PieceType::Pawn);
+        const Bitboard push = shift<Up>(pawns) & empty;
+        if ((push | shift<Up>(push & Rank3)) & empty & target) return true;
+        if ((shift<UpLeft>(pawns) | shift<UpRight>(pawns)) & board.pieces(Them) & target) return true;
+
+        Bitboard knights = free & board.pieces(PieceType::Knight);
+        while (knights) {
+            if (Bitboards::KnightAttacks[popLsb(knights)] & target) return true;
+        }
+
+        // Pinned sliders and pawns stay on the line to their king; pinned knights cannot move.
+        Bitboard pieces = own & ~board.pieces(PieceType::Knight) & ~board.pieces(PieceType::King)
+                        & (~board.pieces(PieceType::Pawn) | pinned);
+        while (pieces) {
+            Square from = popLsb(pieces);
+            Bitboard to = target;
+            if (pinned & squareBB(from)) to &= Bitboards::LineBB[king][from];
+            switch (typeOf(board.pieceOn(from))) {
+            case PieceType::Pawn: {
+                Bitboard one = shift<Up>(squareBB(from)) & empty;
+                to &= one | (shift<Up>(one & Rank3) & empty) | (Bitboards::pawnAttacks(Us, from) & board.pieces(Them));
+                break;
             }
+            case PieceType::Bishop: to &= Bitboards::bishopAttacks(from, occupied); break;
+            case PieceType::Rook:   to &= Bitboards::rookAttacks(from, occupied); break;
+            default:                to &= Bitboards::queenAttacks(from, occupied); break;
+            }
+            if (to) return true;
+        }
 
-            // en-passant capture
-            if (enPass.row == cap.row && enPass.col == cap.col) {
-                // ensure the en-passant target exists and the captured pawn is on the correct square
-                // board.enPassantTarget() should have been set to the square behind the moved pawn
-                Move m{from, cap};
-                m.promotion = Promotion::None;
-                m.isCapture = true;
-                m.isEnpassant = true;
-                m.isCastling = false;
-                out.push_back(m);
+        Square ep = board.enPassantSquare();
+        if (ep != NO_SQUARE) {
+            Bitboard capturers = own & board.pieces(PieceType::Pawn) & Bitboards::pawnAttacks(Them, ep);
+            while (capturers) {
+                if (enPassantIsLegal<Us>(board, popLsb(capturers), ep)) return true;
             }
         }
+        return false;
     }
 
-    static void add_knightMoves(const Board& board, const Position& from, std::vector<Move>& out) {
-        static int dr[8] {-1, -1,  1,  1, -2, -2,  2,  2};
-        static int dc[8] {-2,  2, -2,  2, -1,  1, -1,  1};
-        const Piece* me = board.getPiece(from);
-        for (int i = 0; i < 8; i++) {
-            Position cap(from.row + dr[i], from.col + dc[i]);
-            if (!board.inBounds(cap)) continue;
-            const Piece* target = board.getPiece(cap);
-            if (target && target->color() == me->color()) continue;
-
-            Move m;
-            m.from = from;
-            m.to = cap;
-            m.isCapture = target ? true : false;
-            m.isEnpassant = false;
-            m.isCastling = false;
-            m.promotion = Promotion::None;
-
-            out.push_back(m);
+    static void generate(const Board& board, Bitboard fromMask, GenType type, MoveList& out) {
+        // One fully specialised generator per side and type, so the hot loops test neither.
+        const bool white = board.getTurn() == PieceColor::White;
+        switch (type) {
+        case GenType::All:
+            return white ? generate<PieceColor::White, GenType::All>(board, fromMask, out)
+                         : generate<PieceColor::Black, GenType::All>(board, fromMask, out);
+        case GenType::Captures:
+            return white ? generate<PieceColor::White, GenType::Captures>(board, fromMask, out)
+                         : generate<PieceColor::Black, GenType::Captures>(board, fromMask, out);
+        case GenType::Quiets:
+            return white ? generate<PieceColor::White, GenType::Quiets>(board, fromMask, out)
+                         : generate<PieceColor::Black, GenType::Quiets>(board, fromMask, out);
         }
     }
 
-    static void add_bishopMoves(const Board& board, const Position& from, std::vector<Move>& out) {
-        const Piece* me = board.getPiece(from);
-
-        auto helper = [&](const Position& cap) -> bool {
-            const Piece* target = board.getPiece(cap);
-
-            if (target) {
-                if (target->color() != me->color()) {
-                    Move m;
-                    m.from = from;
-                    m.to = cap;
-                    m.isCapture = true;
-                    m.isEnpassant = false;
-                    m.isCastling = false;
-                    m.promotion = Promotion::None;
-                    out.push_back(m);
-                }
-                return false;
-            }
+    template <PieceColor Us, GenType Type>
+    static void generate(const Board& board, Bitboard fromMask, MoveList& out) {
+        constexpr PieceColor Them = opposite(Us);
+        const Square king = board.kingSquare(Us);
+        if (king == NO_SQUARE) return;
 
-            Move m;
-            m.from = from;
-            m.to = cap;
-            m.isCapture = false;
-            m.isEnpassant = false;
-            m.isCastling = false;
-            m.promotion = Promotion::None;
-            out.push_back(m);
-            return true;
-        };
-
-        for (Position p(from.row + 1, from.col + 1); board.inBounds(p); p.row++, p.col++) {
-            if (!helper(p)) break;
-        }
+        const Bitboard occupied = board.occupied();
+        const Bitboard own = board.pieces(Us);
+        const Bitboard checkers = board.attackersTo(king, Them);
+        // Squares a piece move may go to for this generation type.
+        const Bitboard typeMask = Type == GenType::Captures ? board.pieces(Them)
+                                : Type == GenType::Quiets ? ~occupied : ~0ULL;
 
-        for (Position p(from.row - 1, from.col - 1); board.inBounds(p); p.row--, p.col--) {
-            if (!helper(p)) break;
+        if (fromMask & squareBB(king)) {
+            // The king may not step onto a square attacked once it has left its current square.
+            Bitboard targets = Bitboards::KingAttacks[king] & ~own & typeMask;
+            while (targets) {
+                Square to = popLsb(targets);
+                if (!(board.attackersTo(to, occupied ^ squareBB(king)) & board.pieces(Them)))
+                    out.push_back(Move(king, to, moveFlags<Type>(occupied, to)));
+            }
+            if (Type != GenType::Captures && !checkers) add_castling<Us>(board, king, out);
         }
 
-        for (Position p(from.row - 1, from.col + 1); board.inBounds(p); p.row--, p.col++) {
-            if (!helper(p)) break;
-        }
+        // Double check: only the king can move.
+        if (moreThanOne(checkers)) return;
 
-        for (Position p(from.row + 1, from.col - 1); board.inBounds(p); p.row++, p.col--) {
-            if (!helper(p)) break;
-        }
-    }
+        // Destination squares that resolve a single check, or every non-own square otherwise.
+        const Bitboard target = checkers ? (Bitboards::BetweenBB[king][lsb(checkers)] | checkers) : ~own;
+        const Bitboard pinned = board.blockersForKing(Us) & own;
+        const Bitboard movable = own & fromMask;
 
-    static void add_rookMoves(const Board& board, const Position& from, std::vector<Move>& out) {
-        const Piece* me = board.getPiece(from);
-
-        auto helper = [&](const Position& cap) -> bool {
-            const Piece* target = board.getPiece(cap);
-
-            if (target) {
-                if (target->color() != me->color()) {
-                    Move m;
-                    m.from = from;
-                    m.to = cap;
-                    m.isCapture = true;
-                    m.isEnpassant = false;
-                    m.isCastling = false;
-                    m.promotion = Promotion::None;
-                    out.push_back(m);
-                }
-                return false;
-            }
+        // Pawns sort their moves by kind themselves; promotions do not follow the type mask.
+        add_pawnMoves<Us, Type>(board, movable & board.pieces(PieceType::Pawn), target, pinned, king, out);
+        // A pinned knight can never stay on the line to its king.
+        add_pieceMoves<Type, PieceType::Knight>(board, movable & ~pinned & board.pieces(PieceType::Knight), target & typeMask, pinned, king, out);
+        add_pieceMoves<Type, PieceType::Bishop>(board, movable & board.pieces(PieceType::Bishop), target & typeMask, pinned, king, out);
+        add_pieceMoves<Type, PieceType::Rook>(board, movable & board.pieces(PieceType::Rook), target & typeMask, pinned, king, out);
+        add_pieceMoves<Type, PieceType::Queen>(board, movable & board.pieces(PieceType::Queen), target & typeMask, pinned, king, out);
+    }
 
-            Move m;
-            m.from = from;
-            m.to = cap;
-            m.isCapture = false;
-            m.isEnpassant = false;
-            m.isCastling = false;
-            m.promotion = Promotion::None;
-            out.push_back(m);
-            return true;
-        };
-
-        for (int r = from.row + 1; r < 8; r++) {
-            Position cap({r, from.col});
-            if (!helper(cap)) break;
-        }
+    // Flags of a non-pawn move to `to`; only full generation needs to look at the board.
+    template <GenType Type>
+    static unsigned moveFlags(Bitboard occupied, Square to) {
+        if constexpr (Type == GenType::Captures) return Move::Capture;
+        else if constexpr (Type == GenType::Quiets) return Move::Quiet;
+        else return (occupied & squareBB(to)) ? Move::Capture : Move::Quiet;
+    }
 
-        for (int r = from.row - 1; r >= 0; r--) {
-            Position cap({r, from.col});
-            if (!helper(cap)) break;
+    // Every move of the `pieces` of type Pt to a square in `targets`; pinned pieces only along
+    // the line to their king.
+    template <GenType Type, PieceType Pt>
+    static void add_pieceMoves(const Board& board, Bitboard pieces, Bitboard targets, Bitboard pinned, Square king, MoveList& out) {
+        const Bitboard occupied = board.occupied();
+        while (pieces) {
+            Square from = popLsb(pieces);
+            Bitboard to = Bitboards::attacks<Pt>(from, occupied) & targets;
+            if (pinned & squareBB(from)) to &= Bitboards::LineBB[king][from];
+            while (to) {
+                Square sq = popLsb(to);
+                out.push_back(Move(from, sq, moveFlags<Type>(occupied, sq)));
+            }
         }
+    }
 
-        for (int c = from.col + 1; c < 8; c++) {
-            Position cap({from.row, c});
-            if (!helper(cap)) break;
+    // Pawn moves to the squares in `targets`, each from the square Delta behind it. A pinned
+    // pawn may only move along the line to its king.
+    template <int Delta>
+    static void add_pawnTargets(Bitboard targets, Bitboard pinned, Square king, unsigned flags, MoveList& out) {
+        while (targets) {
+            Square to = popLsb(targets);
+            Square from = to - Delta;
+            if (!(pinned & squareBB(from)) || Bitboards::aligned(king, from, to)) out.push_back(Move(from, to, flags));
         }
+    }
 
-        for (int c = from.col - 1; c >= 0; c--) {
-            Position cap({from.row, c});
-            if (!helper(cap)) break;
+    // Queen promotions count as captures, underpromotions as quiet moves.
+    template <GenType Type, int Delta>
+    static void add_promotions(Bitboard targets, Bitboard pinned, Square king, bool isCapture, MoveList& out) {
+        while (targets) {
+            Square to = popLsb(targets);
+            Square from = to - Delta;
+            if ((pinned & squareBB(from)) && !Bitboards::aligned(king, from, to)) continue;
+            if (Type != GenType::Quiets) out.push_back(Move(from, to, promotionFlags(Promotion::Queen, isCapture)));
+            if (Type == GenType::Captures) continue;
+            for (Promotion pr : {Promotion::Rook, Promotion::Bishop, Promotion::Knight}) {
+                out.push_back(Move(from, to, promotionFlags(pr, isCapture)));
+            }
         }
     }
 
-    static void add_queenMoves(const Board& board, const Position& from, std::vector<Move>& out) {
-        add_rookMoves(board, from, out);
-        add_bishopMoves(board, from, out);
-    }
+    // All pawns move at once, a shift of the whole set per kind of move.
+    template <PieceColor Us, GenType Type>
+    static void add_pawnMoves(const Board& board, Bitboard pawns, Bitboard target, Bitboard pinned, Square king, MoveList& out) {
+        constexpr PieceColor Them = opposite(Us);
+        constexpr int Up = Us == PieceColor::White ? 8 : -8;
+        constexpr int UpLeft = Us == PieceColor::White ? 7 : -9;
+        constexpr int UpRight = Us == PieceColor::White ? 9 : -7;
+        // Rank reached by a single push from the start rank, and the rank before promotion.
+        constexpr Bitboard Rank3 = Us == PieceColor::White ? RANK_3_BB : RANK_6_BB;
+        constexpr Bitboard Rank7 = Us == PieceColor::White ? RANK_7_BB : RANK_2_BB;
 
-    static void add_kingMoves(const Board& board, const Position& from, std::vector<Move>& out) {
-        const Piece* me = board.getPiece(from);
-        for (int dr = -1; dr <= 1; dr++) {
-            for (int dc = -1; dc <= 1; dc++) {
-                if (dr == 0 && dc == 0) continue;
-                Position pos(from.row + dr, from.col + dc);
-                if (!board.inBounds(pos)) continue;
-                const Piece* target = board.getPiece(pos);
-                if (target && target->color() == me->color()) continue;
-                Move m;
-                m.from = from;
-                m.to = pos;
-                m.isCapture = target ? true : false;
-                m.isCastling = false;
-                m.isEnpassant = false;
-                m.promotion = Promotion::None;
-                out.push_back(m);
-            }
+        const Bitboard empty = ~board.occupied();
+        const Bitboard enemies = board.pieces(Them);
+        const Bitboard promoting = pawns & Rank7;
+        const Bitboard others = pawns & ~Rank7;
+
+        if constexpr (Type != GenType::Captures) {
+            Bitboard one = shift<Up>(others) & empty;
+            Bitboard two = shift<Up>(one & Rank3) & empty;
+            add_pawnTargets<Up>(one & target, pinned, king, Move::Quiet, out);
+            add_pawnTargets<2 * Up>(two & target, pinned, king, Move::DoublePush, out);
         }
 
-        // Castling logic
-        // [0]=white kingside, [1]=white queenside, [2]=black kingside, [3]=black queenside
-        PieceColor color = me->color();
-        PieceColor opp = (color == PieceColor::White) ? PieceColor::Black : PieceColor::White;
-        int row = (color == PieceColor::White) ? 7 : 0;
-        int king_col = 4;
-        const bool* castling_rights = board.getCastlingRights();
-        // Kingside
-        int kingside_idx = (color == PieceColor::White) ? 0 : 2;
-        if (from.row == row && from.col == king_col && castling_rights[kingside_idx]) {
-            // Squares between king and rook must be empty
-            if (!board.getPiece({row, 5}) && !board.getPiece({row, 6})) {
-                // King not in check, and does not pass through or land in check
-                if (!isSquareAttacked(board, {row, 4}, opp) &&
-                    !isSquareAttacked(board, {row, 5}, opp) &&
-                    !isSquareAttacked(board, {row, 6}, opp)) {
-                    Move m;
-                    m.from = from;
-                    m.to = {row, 6};
-                    m.isCapture = false;
-                    m.isCastling = true;
-                    m.isEnpassant = false;
-                    m.promotion = Promotion::None;
-                    out.push_back(m);
+        if constexpr (Type != GenType::Quiets) {
+            add_pawnTargets<UpLeft>(shift<UpLeft>(others) & enemies & target, pinned, king, Move::Capture, out);
+            add_pawnTargets<UpRight>(shift<UpRight>(others) & enemies & target, pinned, king, Move::Capture, out);
+
+            // en-passant capture: board.enPassantSquare() is the square behind the pawn that just
+            // double-pushed. It removes two pawns at once, so it is checked on its own below.
+            Square ep = board.enPassantSquare();
+            if (ep != NO_SQUARE) {
+                Bitboard capturers = others & Bitboards::pawnAttacks(Them, ep);
+                while (capturers) {
+                    Square from = popLsb(capturers);
+                    if (enPassantIsLegal<Us>(board, from, ep)) out.push_back(Move(from, ep, Move::EnPassant));
                 }
             }
         }
-        // Queenside
-        int queenside_idx = (color == PieceColor::White) ? 1 : 3;
-        if (from.row == row && from.col == king_col && castling_rights[queenside_idx]) {
-            if (!board.getPiece({row, 1}) && !board.getPiece({row, 2}) && !board.getPiece({row, 3})) {
-                if (!isSquareAttacked(board, {row, 4}, opp) &&
-                    !isSquareAttacked(board, {row, 3}, opp) &&
-                    !isSquareAttacked(board, {row, 2}, opp)) {
-                    Move m;
-                    m.from = from;
-                    m.to = {row, 2};
-                    m.isCapture = false;
-                    m.isCastling = true;
-                    m.isEnpassant = false;
-                    m.promotion = Promotion::None;
-                    out.push_back(m);
-                }
-            }
+
+        if (promoting) {
+            add_promotions<Type, Up>(shift<Up>(promoting) & empty & target, pinned, king, false, out);
+            add_promotions<Type, UpLeft>(shift<UpLeft>(promoting) & enemies & target, pinned, king, true, out);
+            add_promotions<Type, UpRight>(shift<UpRight>(promoting) & enemies & target, pinned, king, true, out);
         }
     }
 
-    // Returns true if the given square is attacked by the given color
-    static bool isSquareAttacked(const Board& board, const Position& sq, PieceColor byColor) {
-        std::vector<Move> theirMoves;
-    MoveGenerator::generateAllSide(board, byColor, theirMoves);
-        for (const auto& m : theirMoves) {
-            if (m.to == sq) return true;
+    // En-passant removes two pawns from the board at once, so pins and check evasion cannot be
+    // read off the masks; test the resulting occupancy directly instead.
+    template <PieceColor Us>
+    static bool enPassantIsLegal(const Board& board, Square from, Square ep) {
+        Square captured = ep + (Us == PieceColor::White ? -8 : 8);
+        Bitboard occupied = (board.occupied() ^ squareBB(from) ^ squareBB(captured)) | squareBB(ep);
+        Bitboard attackers = board.attackersTo(board.kingSquare(Us), occupied)
+                           & board.pieces(opposite(Us)) & ~squareBB(captured);
+        return attackers == 0;
+    }
+
+    template <PieceColor Us>
+    static void add_castling(const Board& board, Square king, MoveList& out) {
+        constexpr PieceColor Them = opposite(Us);
+        constexpr int row = Us == PieceColor::White ? 7 : 0;
+        if (king != makeSquare(row, 4)) return;
+        uint8_t castling_rights = board.getCastlingRights();
+        Bitboard occupied = board.occupied();
+        // Kingside: squares between king and rook empty, and the king does not pass through or
+        // land on an attacked square. It is not in check, the caller made sure of that.
+        constexpr uint8_t kingside = Us == PieceColor::White ? WHITE_OO : BLACK_OO;
+        if (castling_rights & kingside) {
+            constexpr Square f = makeSquare(row, 5), g = makeSquare(row, 6);
+            if (!(occupied & (squareBB(f) | squareBB(g))) &&
+                !board.isSquareAttacked(f, Them) && !board.isSquareAttacked(g, Them)) {
+                out.push_back(Move(king, g, Move::KingCastle));
+            }
+        }
+        // Queenside: the b-file square must be empty too, but may be attacked.
+        constexpr uint8_t queenside = Us == PieceColor::White ? WHITE_OOO : BLACK_OOO;
+        if (castling_rights & queenside) {
+            constexpr Square b = makeSquare(row, 1), c = makeSquare(row, 2), d = makeSquare(row, 3);
+            if (!(occupied & (squareBB(b) | squareBB(c) | squareBB(d))) &&
+                !board.isSquareAttacked(d, Them) && !board.isSquareAttacked(c, Them)) {
+                out.push_back(Move(king, c, Move::QueenCastle));
+            }
         }
-        return false;
     }
 };
@@ -0,0 +1,61 @@
+#pragma once
+#include "board.h"
+#include "Move.h"
+
+// Static exchange evaluation: whether the exchange `move` starts on its target square, each
+// side recapturing with its least valuable piece for as long as that pays, gains at least
+// `threshold` centipawns. Castling, en passant and promotions count as gaining nothing.
+bool seeGe(const Board& board, Move move, int threshold);
+
+// Hands out the legal moves of a position one at a time, most promising first, and generates
+// each group only when the search gets to it, so a cutoff on an early move never pays for the
+// quiet moves:
+//   1. the transposition table move,
+//   2. captures and queen promotions that do not lose material, by MVV-LVA,
+//   3. the two killer moves,
+//   4. the remaining quiet moves, by history,
+//   5. the captures that lose material.
+// No move is returned twice. The board must not change while the picker is in use.
+class MovePicker {
+public:
+    // Main search. `killers` holds two quiet moves that caused cutoffs at this ply and `history`
+    // the side to move's history scores by from and to square.
+    MovePicker(const Board& board, Move ttMove, const Move* killers, const int (*history)[64]);
+    // Quiescence search: only captures and queen promotions, by MVV-LVA and losing ones too,
+    // after the TT move if it is one of them. In check every evasion, as in the main search.
+    MovePicker(const Board& board, Move ttMove);
+
+    // The next move, or a null move when there are none left.
+    Move next();
+
+private:
+    enum class Stage : uint8_t {
+        TTMove, GenerateCaptures, GoodCaptures, Killers, GenerateQuiets, Quiets, BadCaptures,
+        QTTMove, QGenerateCaptures, QCaptures, Done
+    };
+
+    // Whether `move`, from another position, can be played here.
+    bool usable(Move move) const { return board_.isPseudoLegal(move) && board_.isLegal(move); }
+    // Swap the best-scored move from index `cur` on into `cur` and return it.
+    static Move pickBest(MoveList& moves, int* scores, size_t cur);
+    void scoreCaptures();
+    void scoreQuiets();
+
+    const Board& board_;
+    Stage stage_;
+    Move ttMove_;
+    Move killers_[2] = {};
+    const int (*history_)[64] = nullptr;
+
+    // Captures still to try from captureIndex_ on; the losing ones, once seen, are moved to the
+    // front, where badIndex_ walks them last.
+    MoveList captures_;
+    int captureScores_[MAX_MOVES];
+    size_t captureIndex_ = 0;
+    size_t badCount_ = 0;
+    size_t badIndex_ = 0;
+    int killerIndex_ = 0;
+    MoveList quiets_;
+    int quietScores_[MAX_MOVES];
+    size_t quietIndex_ = 0;
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include "board.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Efficiently updatable neural network evaluation.
+//
+// Network: 768 inputs -> 256 per perspective -> 32 -> 1.
+//   Inputs are one-hot (piece type, piece color relative to the perspective, square), with the
+//   board seen from the perspective's side and mirrored left-right when its king is on files
+//   e-h. The 256-wide first layer ("accumulator") is kept per position and updated from the
+//   pieces a move adds and removes instead of being recomputed.
+//   The two accumulators, side to move first, are clipped to [0, 127] and fed to a 512 -> 32
+//   int8 layer, clipped again after a shift by L1_SHIFT, and reduced by a 32 -> 1 int8 layer.
+//   The result divided by OUTPUT_DIVISOR is the evaluation in centipawns.
+//
+// Weights file, little endian:
+//   char[4] "CNNU", uint32 version (1), uint32 HIDDEN,
+//   int16 ftBias[HIDDEN], int16 ftWeights[INPUTS][HIDDEN],
+//   int32 l1Bias[L1_OUTPUTS], int8 l1Weights[L1_OUTPUTS][L1_INPUTS],
+//   int32 l2Bias, int8 l2Weights[L1_OUTPUTS].
+namespace Nnue {
+
+constexpr int INPUTS = 768;
+constexpr int HIDDEN = 256;
+constexpr int L1_INPUTS = 2 * HIDDEN;
+constexpr int L1_OUTPUTS = 32;
+constexpr int L1_SHIFT = 6;
+constexpr int OUTPUT_DIVISOR = 16;
+
+// Instruction sets with a kernel implementation, slowest first.
+enum class Isa { Scalar, Sse41, Avx2 };
+
+const char* isaName(Isa isa);
+bool isaSupported(Isa isa);
+// The fastest instruction set this build and CPU support.
+Isa bestIsa();
+
+// The inner loops, one set per instruction set. All sets give identical results.
+struct Kernels {
+    // dst = src + sum of adds - sum of subs, HIDDEN lanes each. dst may equal src.
+    void (*update)(int16_t* dst, const int16_t* src, const int16_t* const* adds, int addCount,
+                   const int16_t* const* subs, int subCount);
+    // Clip both accumulators to [0, 127] into one L1_INPUTS byte vector, `us` first.
+    void (*transform)(const int16_t* us, const int16_t* them, uint8_t* out);
+    // out[j] = bias[j] + dot(input, weights row j) for L1_OUTPUTS rows of L1_INPUTS weights.
+    void (*affine)(const uint8_t* input, const int8_t* weights, const int32_t* bias, int32_t* out);
+};
+
+const Kernels& kernels(Isa isa);
+
+class Network {
+public:
+    Network();
+
+    // Load weights in the format above. On failure returns false, sets `error` and leaves the
+    // network unchanged.
+    bool load(const std::string& path, std::string& error);
+    // Small deterministic pseudo-random weights; enough to exercise and benchmark the code.
+    void randomize(uint64_t seed);
+
+    // Kernels used by this network and every Evaluator on it. Defaults to bestIsa().
+    void setIsa(Isa isa);
+    Isa isa() const { return isa_; }
+
+    // Evaluation from the side to move's point of view, computing both accumulators from
+    // scratch. Evaluator gives the same result incrementally.
+    int evaluate(const Board& board) const;
+
+private:
+    friend class Evaluator;
+
+    // First layer column of an input feature.
+    const int16_t* column(int feature) const { return ftWeights_.data() + feature * HIDDEN; }
+    void refresh(const Board& board, PieceColor perspective, int16_t* out) const;
+    int propagate(const int16_t* us, const int16_t* them) const;
+
+    std::vector<int16_t> ftBias_;
+    std::vector<int16_t> ftWeights_;
+    std::vector<int32_t> l1Bias_;
+    std::vector<int8_t> l1Weights_;
+    int32_t l2Bias_ = 0;
+    std::vector<int8_t> l2Weights_;
+
+    Isa isa_;
+    const Kernels* kernels_;
+};
+
+// Index of the input feature for `code` on `sq`, seen by `perspective` whose king is on `ksq`.
+int featureIndex(PieceColor perspective, Square ksq, PieceCode code, Square sq);
+
+// Incremental evaluation along a line of play. Keeps one accumulator pair per ply of the
+// board's history and computes them lazily: evaluate() finds the nearest earlier ply whose
+// accumulator is still valid and applies each move's piece deltas from there. A perspective's
+// accumulator is rebuilt from scratch only when its king crosses between the d and e files,
+// which changes the mirroring of every feature.
+class Evaluator {
+public:
+    explicit Evaluator(const Network* network = nullptr) : network_(network) {}
+
+    // Switch networks; drops every cached accumulator.
+    void setNetwork(const Network* network);
+    const Network* network() const { return network_; }
+
+    // Evaluation of `board` from the side to move's point of view. Requires a network.
+    int evaluate(const Board& board);
+
+private:
+    struct alignas(64) Accumulator {
+        int16_t values[2][HIDDEN]; // [0] white's perspective, [1] black's
+        uint64_t key = 0;          // position the values belong to
+        bool computed[2] = {false, false};
+    };
+
+    void update(const Board& board, int ply, int perspective);
+
+    const Network* network_;
+    std::vector<Accumulator> stack_;
+};
+
+} // namespace Nnue
@@ -0,0 +1,101 @@
+#pragma once
+#include "MappedFile.h"
+#include "PackedPosition.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Files of PackedPosition records. The records are stored in chunks of a fixed number of
+// positions, each chunk either raw or compressed with zlib, followed by an index of where each
+// chunk starts:
+//   header   PackedFileHeader
+//   chunks   chunk i holds positions [i * chunkSize, (i + 1) * chunkSize), the last one fewer
+//   index    chunks + 1 uint64 file offsets, the last one the end of the final chunk
+// Everything is little endian. Uncompressed files are a plain array of records after the header.
+enum class PackedCompression : uint32_t { None, Zlib };
+
+struct PackedFileHeader {
+    static constexpr char MAGIC[8] = {'P', 'A', 'C', 'K', 'P', 'O', 'S', '1'};
+
+    char magic[8] = {};
+    PackedCompression compression = PackedCompression::None;
+    uint32_t chunkSize = 0;   // positions per chunk
+    uint64_t count = 0;       // positions in the file
+    uint64_t indexOffset = 0; // file offset of the chunk index
+};
+static_assert(sizeof(PackedFileHeader) == 32, "PackedFileHeader is a file format");
+
+// Whether this build can read and write zlib-compressed files.
+bool packedZlibAvailable();
+
+// Writes a packed file one position at a time, keeping one chunk in memory.
+class PackedWriter {
+public:
+    // 128 KiB of raw records: large enough to compress well, small enough to decode per lookup.
+    static constexpr uint32_t DEFAULT_CHUNK_SIZE = 4096;
+
+    PackedWriter() = default;
+    // Finishes the file if close() was not called; errors are then lost.
+    ~PackedWriter();
+
+    PackedWriter(const PackedWriter&) = delete;
+    PackedWriter& operator=(const PackedWriter&) = delete;
+
+    // Create `path`. Fails if it cannot be created or if zlib is asked for in a build without it.
+    bool open(const std::string& path, PackedCompression compression, std::string& error,
+              uint32_t chunkSize = DEFAULT_CHUNK_SIZE);
+    void write(const PackedPosition& position);
+    // Write the last chunk, the index and the final header. False if anything failed to write.
+    bool close(std::string& error);
+
+    uint64_t count() const { return count_; }
+
+private:
+    void flushChunk();
+
+    std::ofstream out_;
+    PackedFileHeader header_;
+    std::vector<PackedPosition> chunk_;
+    std::vector<unsigned char> compressed_;
+    std::vector<uint64_t> offsets_;
+    uint64_t count_ = 0;
+    bool failed_ = false;
+};
+
+// Reads a packed file through a memory mapping; opening it reads only the header and index.
+class PackedReader {
+public:
+    // Map `path` and check its header and index. On failure returns false and sets `error`.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    uint64_t size() const { return header_.count; }
+    bool compressed() const { return header_.compression != PackedCompression::None; }
+
+    // All records of an uncompressed file, straight from the mapping; nullptr if compressed.
+    const PackedPosition* data() const {
+        return compressed() ? nullptr : reinterpret_cast<const PackedPosition*>(file_.data() + sizeof(PackedFileHeader));
+    }
+
+    // Copy record `index` (< size()) into `out`. A compressed chunk is decoded on first use and
+    // kept until another one is needed, so reading in order decodes each chunk once. False if
+    // the chunk is corrupt. Not thread-safe; use one reader per thread or readChunk().
+    bool read(uint64_t index, PackedPosition& out);
+
+    size_t chunkCount() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+    uint32_t chunkSize() const { return header_.chunkSize; }
+    // Decode chunk `chunk` into `out`, replacing its contents. Thread-safe. False if corrupt.
+    bool readChunk(size_t chunk, std::vector<PackedPosition>& out) const;
+
+    // Hint that the file will be read front to back.
+    void adviseSequential() const { file_.adviseSequential(); }
+
+private:
+    MappedFile file_;
+    PackedFileHeader header_;
+    std::vector<uint64_t> offsets_;
+    std::vector<PackedPosition> cache_;
+    size_t cachedChunk_ = SIZE_MAX;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include "Bitboard.h"
+#include <cstdint>
+
+// Outcome of the game a position was taken from, as stored with packed positions.
+enum class GameResult : uint8_t { Unknown, WhiteWins, Draw, BlackWins };
+
+// A position in 32 bytes, for datasets of billions of positions: the occupied squares, then a
+// 4-bit code per piece in square order, then the rest of the FEN in one word. Room is left for
+// a score, a move and the game result, which Board::pack leaves empty. Also the record of the
+// packed file format: the fields in this order, little endian.
+struct PackedPosition {
+    static constexpr int16_t NO_SCORE = INT16_MIN;
+    // Counters beyond these are stored as these.
+    static constexpr int MAX_HALFMOVE_CLOCK = 255;
+    static constexpr int MAX_FULLMOVE_NUMBER = 8191;
+
+    uint64_t occupied = 0;    // squares with a piece, a1 = bit 0
+    // The pieces on `occupied`, lowest square first, two per byte with the first in the low
+    // nibble. Each is its PieceCode - 8: 1-6 for white pawn to king, 9-14 for black.
+    uint8_t pieces[16] = {};
+    // Bit 0 black to move, bits 1-4 castling rights, bits 5-8 en-passant file + 1 (0 for none),
+    // bits 9-10 GameResult, bits 11-18 halfmove clock, bits 19-31 fullmove number.
+    uint32_t state = 0;
+    int16_t score = NO_SCORE; // centipawns from the side to move's point of view
+    uint16_t move = 0;        // Move::raw() of a move played or recommended; 0 for none
+
+    GameResult result() const { return static_cast<GameResult>((state >> 9) & 3); }
+    void setResult(GameResult r) { state = (state & ~(3u << 9)) | (static_cast<uint32_t>(r) << 9); }
+};
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition is a file format");
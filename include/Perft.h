@@ -0,0 +1,70 @@
+#pragma once
+#include "board.h"
+#include "Move.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Hash table of subtree leaf counts for perft. Each entry keeps the position key with the
+// remaining depth folded into its low byte, so one probe checks both. Safe to share between
+// threads without locks: the key is stored XORed with the count, so an entry torn by a
+// concurrent store fails the check and reads as a miss.
+class PerftTable {
+public:
+    explicit PerftTable(size_t megabytes);
+
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+    void store(uint64_t key, int depth, uint64_t nodes);
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> keyXorNodes;
+        std::atomic<uint64_t> nodes;
+    };
+
+    static uint64_t tag(uint64_t key, int depth) { return (key & ~0xFFULL) | static_cast<uint64_t>(depth); }
+
+    std::unique_ptr<Entry[]> entries_;
+    uint64_t mask_;
+};
+
+struct DivideEntry {
+    Move move;
+    uint64_t nodes;
+};
+
+// Leaf count of the legal move tree below `board` at `depth`. The last ply is counted in bulk
+// from the size of the move list. `table` may be null.
+uint64_t perft(Board& board, int depth, PerftTable* table = nullptr);
+
+// perft split by root move, in generator order.
+std::vector<DivideEntry> divide(Board& board, int depth, PerftTable* table = nullptr);
+
+// Work done by one thread of parallelDivide().
+struct PerftThreadStats {
+    uint64_t tasks = 0;      // subtrees searched
+    uint64_t stolen = 0;     // of which taken from another thread's queue
+    uint64_t nodes = 0;      // leaves counted
+    double busySeconds = 0;  // time spent inside tasks
+    double doneSeconds = 0;  // when the thread found no more work, from the start
+};
+
+// divide() on `threads` threads. The tree is split into one task per move sequence of length
+// `splitPly` (clamped to 1..depth-1); each thread starts with an equal share of the tasks and
+// steals from the others once its own run out. Returns exactly what divide() returns. Per
+// thread statistics are written to `stats` if it is not null.
+std::vector<DivideEntry> parallelDivide(const Board& board, int depth, int threads, int splitPly,
+                                        PerftTable* table = nullptr,
+                                        std::vector<PerftThreadStats>* stats = nullptr);
+
+struct PerftPosition {
+    const char* name;
+    const char* fen;
+    // Expected leaf counts for depth 1, 2, ...; 0 terminates.
+    uint64_t nodes[8];
+};
+
+// Startpos, Kiwipete and the other standard perft positions.
+extern const PerftPosition PERFT_SUITE[];
+extern const size_t PERFT_SUITE_SIZE;
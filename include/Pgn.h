@@ -0,0 +1,88 @@
+#pragma once
+#include "board.h"
+#include "MappedFile.h"
+#include "Move.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A tag pair such as [White "Carlsen, Magnus"]. The value is the text between the quotes as
+// written, escapes included, so writing it back reproduces the input.
+struct PgnTag {
+    std::string_view name;
+    std::string_view value;
+};
+
+// One game of a PGN file. The views point into the reader's input.
+struct PgnGame {
+    static constexpr int MAX_TAGS = 64;
+
+    int tagCount = 0;
+    PgnTag tags[MAX_TAGS];
+    // Position before the first move: the FEN tag's, or the standard start.
+    Board start;
+    // The main line. Variations, comments and NAGs are skipped.
+    std::vector<Move> moves;
+    // "1-0", "0-1", "1/2-1/2" or "*"; empty if the game text ended without one.
+    std::string_view result;
+    // The whole game as it appears in the input.
+    std::string_view text;
+    // Set when the game could not be read completely; moves then holds the main line up to the
+    // offending move and errorOffset is where it starts in `text`.
+    const char* error = nullptr;
+    size_t errorOffset = 0;
+
+    // Value of the tag `name`, or an empty view.
+    std::string_view tag(std::string_view name) const;
+};
+
+// Streams the games of a PGN file. The main line's SAN moves are resolved to Move as they are
+// read; the text itself is never copied. Reusing one PgnGame for every game avoids allocating
+// once its move list has grown.
+class PgnReader {
+public:
+    PgnReader() = default;
+    // Read games from text owned by the caller.
+    explicit PgnReader(std::string_view text) : text_(text) {}
+
+    // Map `path` and read games from it. On failure returns false and sets `error`.
+    bool open(const std::string& path, std::string& error);
+
+    // Read the next game into `game`; false at the end of the input. A game with an error is
+    // still returned, with game.error set, and reading continues after it.
+    bool next(PgnGame& game);
+
+    const std::string_view& text() const { return text_; }
+    // Bytes consumed so far, for progress reports.
+    size_t position() const { return pos_; }
+
+private:
+    void readTags(PgnGame& game);
+    void readMovetext(PgnGame& game);
+
+    MappedFile file_;
+    std::string_view text_;
+    size_t pos_ = 0;
+    // Position the main line is played on.
+    Board board_;
+};
+
+// Append `game` as PGN: its tags, a blank line, the main line in SAN with move numbers, wrapped
+// at 80 columns, and the result ("*" if it has none), followed by a blank line.
+void writePgn(const PgnGame& game, std::string& out);
+
+struct PgnStats {
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    uint64_t errors = 0;
+};
+
+// Read all games of `text` on `threads` threads. The text is cut into pieces at game starts (a
+// '[' line after a blank line) and each thread reads whole pieces with its own reader. `visit`,
+// if set, is called for every game on the thread that read it, with that thread's index in
+// [0, threads): games of one piece arrive in order, pieces in any order.
+PgnStats readPgnParallel(std::string_view text, int threads,
+                         const std::function<void(int thread, const PgnGame& game)>& visit = {});
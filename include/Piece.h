@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 enum class PieceColor { None, White, Black };
 enum class PieceType { None, Pawn, Knight, Bishop, Rook, Queen, King };
@@ -14,11 +15,11 @@ struct Position {
 
 class Piece {
 public:
-    Piece(PieceType type, PieceColor color)
+    constexpr Piece(PieceType type, PieceColor color)
         : type_(type), color_(color) {}
 
-    PieceType type() const { return type_; }
-    PieceColor color() const { return color_; }
+    constexpr PieceType type() const { return type_; }
+    constexpr PieceColor color() const { return color_; }
 
 private:
     PieceType type_;
@@ -26,3 +27,18 @@ private:
 };
 
 enum class Promotion { None, Knight, Bishop, Rook, Queen };
+
+constexpr PieceColor opposite(PieceColor c) {
+    return c == PieceColor::White ? PieceColor::Black : PieceColor::White;
+}
+
+// Compact piece code stored in the board's square array: color in bits 3-4, type in bits 0-2.
+// 0 means an empty square.
+using PieceCode = uint8_t;
+constexpr int PIECE_CODE_NB = 24;
+
+constexpr PieceCode makePieceCode(PieceType type, PieceColor color) {
+    return static_cast<PieceCode>((static_cast<int>(color) << 3) | static_cast<int>(type));
+}
+constexpr PieceType typeOf(PieceCode code) { return static_cast<PieceType>(code & 7); }
+constexpr PieceColor colorOf(PieceCode code) { return static_cast<PieceColor>(code >> 3); }
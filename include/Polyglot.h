@@ -0,0 +1,58 @@
+#pragma once
+#include "board.h"
+#include "MappedFile.h"
+#include "Move.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Polyglot opening books (.bin): 16-byte big-endian entries {uint64 key, uint16 move,
+// uint16 weight, uint32 learn} sorted by key, where the key is a Zobrist hash over the fixed
+// "Random64" table of the Polyglot format.
+namespace Polyglot {
+
+// 12 * 64 piece-square keys, 4 castling keys, 8 en-passant file keys, 1 side-to-move key.
+constexpr int RANDOM_COUNT = 781;
+
+// Polyglot key of `board`, from the standard Random64 table built into the program.
+uint64_t key(const Board& board);
+
+// Check key() against the reference keys of the Polyglot specification. Book::open runs it
+// once and refuses books if it fails.
+bool checkKeys(std::string& error);
+
+struct BookEntry {
+    Move move;       // a legal move of the probed position
+    uint16_t weight;
+};
+
+// How to choose among the book moves of a position.
+enum class Pick { Best, Weighted };
+
+// A book file mapped into memory and binary-searched in place; opening it reads nothing.
+class Book {
+public:
+    // Map the book at `path`. On failure returns false and sets `error`.
+    bool open(const std::string& path, std::string& error);
+    void close();
+    bool isOpen() const { return file_.isOpen(); }
+    size_t size() const { return file_.size() / ENTRY_SIZE; }
+
+    // Append the book's moves for `board` with key `key` to `out`, heaviest first. Entries
+    // whose move is not legal in `board` are skipped.
+    void probe(const Board& board, uint64_t key, std::vector<BookEntry>& out) const;
+
+    // One book move for `board`, or a null move if the book has none. Weighted picks with
+    // probability proportional to weight, using `random` as the random draw.
+    Move pick(const Board& board, Pick mode, uint64_t random) const;
+
+private:
+    static constexpr size_t ENTRY_SIZE = 16;
+
+    uint64_t keyAt(size_t index) const;
+
+    MappedFile file_;
+};
+
+} // namespace Polyglot
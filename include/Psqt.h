@@ -0,0 +1,35 @@
+#pragma once
+#include "Bitboard.h"
+#include "Piece.h"
+#include <cstdint>
+
+// A middlegame and an endgame value packed into one int, so both halves of an evaluation term
+// are accumulated with a single add. The endgame half lives in the upper 16 bits.
+using Score = int32_t;
+
+constexpr Score makeScore(int mg, int eg) {
+    return static_cast<Score>(static_cast<uint32_t>(eg) << 16) + mg;
+}
+
+constexpr int mgValue(Score s) {
+    return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(s)));
+}
+
+constexpr int egValue(Score s) {
+    return static_cast<int16_t>(static_cast<uint16_t>((static_cast<uint32_t>(s) + 0x8000) >> 16));
+}
+
+// Material plus piece-square values, from white's point of view: black pieces have negated
+// values on mirrored squares. Board keeps their sum up to date as pieces move.
+namespace Psqt {
+
+extern Score Table[PIECE_CODE_NB][64];
+
+// Game phase contributed by each PieceType; a full set of pieces adds up to MAX_PHASE.
+constexpr int PHASE_WEIGHT[7] = {0, 0, 1, 1, 2, 4, 0};
+constexpr int MAX_PHASE = 24;
+
+// Fill Table. Called once from a static initializer in psqt.cpp.
+void init();
+
+} // namespace Psqt
@@ -0,0 +1,26 @@
+#pragma once
+#include "board.h"
+#include "Move.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Standard algebraic notation, e.g. "Nbd7", "exd6", "e8=Q+", "O-O-O".
+namespace San {
+
+// Longest SAN written by toSan(), with the terminating zero ("Qa1xb2+" is 7 characters, a
+// promotion with capture and check "exd8=Q#" the same).
+constexpr size_t BUFFER_SIZE = 16;
+
+// The legal move `san` stands for in `board`, or a null move if there is none or it is
+// ambiguous. The piece and target square select candidates straight from the attack tables, so
+// no move list is generated. Check, mate and annotation suffixes ("+", "#", "!?") are ignored;
+// "0-0" is accepted for "O-O" and the '=' before a promotion piece is optional.
+Move parse(const Board& board, std::string_view san);
+
+// Write `move`, legal in `board`, as SAN into `out` (at least BUFFER_SIZE bytes) and return its
+// length. The check or mate suffix needs the move played; `board` is restored before returning.
+size_t write(Board& board, Move move, char* out);
+std::string toSan(Board& board, Move move);
+
+} // namespace San
@@ -0,0 +1,199 @@
+#pragma once
+#include "board.h"
+#include "Move.h"
+#include "TranspositionTable.h"
+#include "Nnue.h"
+#include "Syzygy.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int MAX_PLY = 128;
+
+constexpr int VALUE_DRAW = 0;
+constexpr int VALUE_MATE = 32000;
+constexpr int VALUE_INFINITE = 32001;
+constexpr int VALUE_NONE = 32002;
+// Scores beyond these bounds are mates found within MAX_PLY.
+constexpr int VALUE_MATE_IN_MAX_PLY = VALUE_MATE - MAX_PLY;
+constexpr int VALUE_MATED_IN_MAX_PLY = -VALUE_MATE_IN_MAX_PLY;
+// Tablebase wins score VALUE_TB_WIN - ply, below every mate so a real mate is still preferred.
+constexpr int VALUE_TB_WIN = VALUE_MATE_IN_MAX_PLY - 1;
+constexpr int VALUE_TB_WIN_IN_MAX_PLY = VALUE_TB_WIN - MAX_PLY;
+
+// What to search for and when to stop. Zero means "no limit" for every field.
+struct SearchLimits {
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t movetime = 0;   // ms for this move
+    int64_t time[2] = {0, 0};      // remaining clock ms, [0] white, [1] black
+    int64_t increment[2] = {0, 0}; // ms per move
+    int movestogo = 0;
+    bool infinite = false;
+};
+
+// Progress report after each completed iteration.
+struct SearchInfo {
+    int depth = 0;
+    int seldepth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    uint64_t nps = 0;
+    uint64_t tbHits = 0;
+    int64_t timeMs = 0;
+    int hashfull = 0;
+    std::vector<Move> pv;
+    // Nodes searched by each thread so far, main thread first.
+    std::vector<uint64_t> threadNodes;
+};
+
+struct SearchResult {
+    Move bestMove{};
+    Move ponderMove{};
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    // Nodes searched by each thread, main thread first.
+    std::vector<uint64_t> threadNodes;
+};
+
+// UCI "info" line for a report, e.g. "info depth 7 score cp 31 nodes ... pv e2e4 e7e5".
+std::string formatInfo(const SearchInfo& info);
+
+struct PvLine {
+    int length = 0;
+    Move moves[MAX_PLY];
+};
+
+class Search;
+
+// One search thread's private state: its own copy of the position, killers, history and PV
+// stack. Workers share nothing but the transposition table and the stop flag.
+class SearchWorker {
+public:
+    SearchWorker(Search& owner, int index) : owner_(owner), index_(index) {}
+
+    uint64_t nodes() const { return nodes_.load(std::memory_order_relaxed); }
+
+private:
+    friend class Search;
+
+    // Iterative deepening from the owner's root position until stopped.
+    void iterate();
+    int search(int depth, int alpha, int beta, int ply, bool pvNode, PvLine& pv);
+    int quiesce(int alpha, int beta, int ply);
+
+    void updateQuietStats(Move best, int depth, int ply, const Move* quiets, int quietCount);
+
+    // Network evaluation when the owner has a network, the hand-written one otherwise.
+    int staticEval();
+    bool stopped() const;
+    // Count a node; the main thread also polls the limits every few thousand nodes.
+    void visitNode();
+    bool isMainThread() const { return index_ == 0; }
+
+    Search& owner_;
+    const int index_;
+    Board board_;
+
+    // Written only by this thread, read by the main thread for limits and reporting. A plain
+    // load/store pair keeps the increment as cheap as a non-atomic one.
+    std::atomic<uint64_t> nodes_{0};
+    std::atomic<uint64_t> tbHits_{0};
+    int seldepth_ = 0;
+
+    // Deepest completed iteration and its result, used for voting.
+    int completedDepth_ = 0;
+    int completedScore_ = 0;
+    PvLine completedPv_;
+
+    Nnue::Evaluator nnue_;
+
+    Move killers_[MAX_PLY][2];
+    // History of quiet moves that caused cutoffs, by color, from and to square.
+    int history_[2][64][64];
+};
+
+// Lazy SMP search: every thread runs its own iterative-deepening alpha-beta search (negamax
+// with principal variation search, aspiration windows and quiescence search) over make/unmake
+// on the same root, and they cooperate only through the shared transposition table. Helper
+// threads skip some depths so the threads spread over different iterations.
+class Search {
+public:
+    explicit Search(TranspositionTable& tt, int threads = 1);
+    ~Search();
+
+    Search(const Search&) = delete;
+    Search& operator=(const Search&) = delete;
+
+    // Number of search threads including the calling thread. Not while a search is running.
+    void setThreads(int count);
+    int threadCount() const { return static_cast<int>(workers_.size()); }
+
+    // Search `root` until the limits are reached or stop() is called, then return the best move
+    // voted by all threads. Blocks; the calling thread acts as the main search thread. Calls
+    // onInfo (if set) after every depth the main thread completes.
+    SearchResult run(const Board& root, const SearchLimits& limits);
+
+    // run() on a background thread; returns at once. `done` is called on that thread with the
+    // result. A stop() issued any time after start() returns ends this search.
+    void start(const Board& root, const SearchLimits& limits, std::function<void(const SearchResult&)> done);
+    // Block until a search begun with start() has finished and its `done` has returned.
+    void wait();
+
+    // Evaluate with `network`, or with evaluate() when null. The network must outlive its use
+    // and not change while a search is running.
+    void setNetwork(const Nnue::Network* network) { network_ = network; }
+    // Probe `tablebases`, or nothing when null: WDL inside the tree, DTZ to pick the root
+    // moves. Same lifetime rules as setNetwork().
+    void setTablebases(const Syzygy::Tablebases* tablebases) { tablebases_ = tablebases; }
+
+    // Ask a running search to finish as soon as possible. Safe to call from any thread.
+    void stop() { stop_.store(true, std::memory_order_relaxed); }
+
+    std::function<void(const SearchInfo&)> onInfo;
+
+private:
+    friend class SearchWorker;
+    using Clock = std::chrono::steady_clock;
+
+    // A pool thread parked on a condition variable between searches.
+    class HelperThread;
+
+    // run() without clearing stop_ first.
+    SearchResult think(const Board& root, const SearchLimits& limits);
+    void setupTimeControl(const SearchLimits& limits, PieceColor us);
+    // Called by the main thread every few thousand nodes; raises stop_ once a hard limit is hit.
+    void checkLimits();
+    int64_t elapsedMs() const;
+    uint64_t totalNodes() const;
+    uint64_t totalTbHits() const;
+    void report(const SearchWorker& main, int depth, int score, const PvLine& pv);
+    // The thread whose result to play: weighs each thread's move by depth and score.
+    const SearchWorker& voteBestThread() const;
+
+    TranspositionTable& tt_;
+    const Nnue::Network* network_ = nullptr;
+    const Syzygy::Tablebases* tablebases_ = nullptr;
+    std::atomic<bool> stop_{false};
+
+    Board root_;
+    // Moves searched at the root: the legal moves, less those the tablebases rule out.
+    MoveList rootMoves_;
+    SearchLimits limits_;
+    Clock::time_point start_;
+    int64_t softLimitMs_ = 0;
+    int64_t hardLimitMs_ = 0;
+
+    // workers_[0] belongs to the thread calling run(); helpers_[i] drives workers_[i + 1].
+    std::vector<std::unique_ptr<SearchWorker>> workers_;
+    std::vector<std::unique_ptr<HelperThread>> helpers_;
+    // Runs searches begun with start().
+    std::thread background_;
+};
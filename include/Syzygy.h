@@ -0,0 +1,87 @@
+#pragma once
+#include "board.h"
+#include "Move.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Syzygy endgame tablebases: WDL tables (.rtbw) give the game-theoretic result of a position
+// under the fifty-move rule, DTZ tables (.rtbz) the distance to the next capture or pawn move
+// that keeps it. Tables are found by name in local directories and each file is mapped into
+// memory on its first probe, so indexing a directory of many gigabytes reads nothing.
+namespace Syzygy {
+
+// Results from the side to move's point of view. Cursed wins and blessed losses are wins and
+// losses that the fifty-move rule turns into draws.
+enum Wdl : int { Loss = -2, BlessedLoss = -1, Draw = 0, CursedWin = 1, Win = 2 };
+
+// Largest tables handled; the encoding of 8-piece tables is not supported.
+constexpr int MAX_PIECES = 7;
+
+struct Table;
+
+// The tables of one or more directories. Probing is thread-safe and takes a mutex only the
+// first time a table is touched; init() must not run while any thread probes.
+class Tablebases {
+public:
+    Tablebases();
+    ~Tablebases();
+
+    Tablebases(const Tablebases&) = delete;
+    Tablebases& operator=(const Tablebases&) = delete;
+
+    // Forget the current tables and index those in `paths`, a list of directories separated by
+    // ':'. Returns the number of WDL tables found.
+    size_t init(const std::string& paths);
+
+    size_t size() const { return wdlCount_; }
+    // Most pieces, kings included, of any table found; 0 without tables.
+    int maxPieces() const { return maxPieces_; }
+
+    // Whether `board` is covered at all: few enough pieces and no castling rights, which the
+    // tables do not encode. A probe can still fail if the table is missing or unreadable.
+    bool covers(const Board& board) const {
+        return maxPieces_ && popcount(board.occupied()) <= maxPieces_ && !board.getCastlingRights();
+    }
+
+    // WDL of `board`, taking en passant into account. Only exact when the last move was a
+    // capture or pawn move; later in a fifty-move sequence the score may be too optimistic.
+    // Returns false if a needed table is missing. `board` is searched but left as it was.
+    bool probeWdl(Board& board, Wdl& wdl) const;
+
+    // Plies to the next zeroing move with best play, the sign giving the result: positive when
+    // the side to move wins, 0 for a draw. Cursed wins and blessed losses are offset by 100.
+    // Off by one for the loser when the count is stored for the other side, as in Syzygy itself.
+    bool probeDtz(Board& board, int& dtz) const;
+
+    // Keep only the root moves that make the best progress within the fifty-move rule: by DTZ
+    // when the DTZ tables are there, by WDL otherwise. Returns false, leaving `moves` alone,
+    // when `board` is not covered.
+    bool filterRootMoves(Board& board, MoveList& moves) const;
+
+private:
+    // Value stored in the WDL or DTZ table for `board` as it stands; no moves are tried.
+    // `wdl` is the known result, which DTZ tables need to decode their values.
+    int probeTable(const Board& board, bool dtz, Wdl wdl, int& state) const;
+    // WDL of `board` from the better of its table value and its captures (with pawn moves too
+    // when `zeroingMoves`), since the tables store "don't care" values where a capture wins.
+    Wdl search(Board& board, bool zeroingMoves, int& state) const;
+    int dtz(Board& board, int& state) const;
+    // Map the file behind `table` if not done yet. False if it cannot be used.
+    bool map(Table& table) const;
+
+    std::vector<std::string> paths_;
+    std::vector<std::unique_ptr<Table>> tables_;
+    // Both material keys of every table (white stronger and black stronger) to its WDL and DTZ
+    // tables; DTZ may be null. Built by init() and only read afterwards.
+    std::unordered_map<uint64_t, std::pair<Table*, Table*>> byKey_;
+    size_t wdlCount_ = 0;
+    int maxPieces_ = 0;
+    // Serialises the first-time mapping of tables.
+    mutable std::mutex mapMutex_;
+};
+
+} // namespace Syzygy
@@ -0,0 +1,92 @@
+#pragma once
+#include "Move.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class Bound : uint8_t { None, Upper, Lower, Exact };
+
+// What a probe returns. Scores are stored exactly as passed to store(); adjusting mate scores
+// for distance from the root is up to the caller.
+struct TTData {
+    Move move;
+    int score;
+    int eval;
+    int depth;
+    Bound bound;
+};
+
+// Shared hash table of search results, safe to use from any number of threads without locks.
+//
+// Each entry is two 64-bit words: the packed data and the position key XORed with that data.
+// A reader that sees a torn write (words from two different stores) gets a key mismatch and
+// treats it as a miss, so no entry can be attributed to the wrong position. Four entries fill
+// one 64-byte cache-line-aligned bucket. Shared by all search threads; perft keeps its own
+// PerftTable, since its 64-bit leaf counts do not fit the 16-bit score field.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Reallocate to `megabytes` (contents are lost). Not thread-safe.
+    void resize(size_t megabytes);
+    // Zero every entry. Not thread-safe.
+    void clear();
+    // Start a new search: entries from older searches become preferred replacement victims.
+    void newSearch() { generation_ = (generation_ + 1) & GENERATION_MASK; }
+
+    bool probe(uint64_t key, TTData& out) const;
+    void store(uint64_t key, int depth, Bound bound, int score, int eval, Move move);
+
+    // Hint the CPU to start loading the bucket for `key`; issue right after makeMove so the
+    // line is in cache by the time the child node probes.
+    void prefetch(uint64_t key) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&buckets_[bucketIndex(key)]);
+#endif
+    }
+
+    // Permille of sampled entries written during the current search, as reported by UCI.
+    int hashfull() const;
+
+    size_t sizeMB() const { return bucketCount_ * sizeof(Bucket) / (1024 * 1024); }
+
+private:
+    static constexpr int ENTRIES_PER_BUCKET = 4;
+    static constexpr uint8_t GENERATION_MASK = 63;
+
+    struct Entry {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[ENTRIES_PER_BUCKET];
+    };
+    static_assert(sizeof(Bucket) == 64, "bucket must fill exactly one cache line");
+
+    // data layout: move 0-15, score 16-31, eval 32-47, depth 48-55, bound 56-57, generation 58-63
+    static uint64_t pack(Move move, int score, int eval, int depth, Bound bound, uint8_t generation);
+    static TTData unpack(uint64_t data);
+    static uint8_t generationOf(uint64_t data) { return static_cast<uint8_t>(data >> 58); }
+    static int depthOf(uint64_t data) { return static_cast<int8_t>(data >> 48); }
+
+    // Map the key onto [0, bucketCount_) with a multiply-high, so any bucket count works.
+    size_t bucketIndex(uint64_t key) const {
+#if defined(__SIZEOF_INT128__)
+        return static_cast<size_t>((static_cast<unsigned __int128>(key) * bucketCount_) >> 64);
+#else
+        return static_cast<size_t>(key % bucketCount_);
+#endif
+    }
+
+    void release();
+
+    Bucket* buckets_ = nullptr;
+    size_t bucketCount_ = 0;
+    size_t allocatedBytes_ = 0;
+    uint8_t generation_ = 0;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include "board.h"
+#include "Nnue.h"
+#include "Polyglot.h"
+#include "Search.h"
+#include "Syzygy.h"
+#include "TranspositionTable.h"
+
+#include <condition_variable>
+#include <iosfwd>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+
+// Universal Chess Interface front end. Commands are handled on the calling thread and each
+// "go" searches on a background thread, so "stop", "isready" and "quit" are answered while the
+// engine thinks.
+class UciEngine {
+public:
+    explicit UciEngine(std::ostream& out);
+    ~UciEngine();
+
+    // Handle commands read from `in` until "quit" or the end of input.
+    void loop(std::istream& in);
+    // Handle one command line. Returns false for "quit".
+    bool execute(const std::string& line);
+
+private:
+    static constexpr int DEFAULT_HASH_MB = 16;
+    static constexpr int MAX_HASH_MB = 65536;
+    static constexpr int MAX_THREADS = 256;
+
+    // Write one line; safe from the search thread.
+    void send(const std::string& line);
+
+    void uci();
+    void setOption(std::istringstream& args);
+    void position(std::istringstream& args);
+    void go(std::istringstream& args);
+    // End the current search, if any, and wait for its "bestmove".
+    void stopSearch();
+
+    std::ostream& out_;
+    std::mutex outMutex_;
+
+    TranspositionTable tt_;
+    Search search_;
+    Nnue::Network network_;
+    Board board_;
+
+    // Book moves are played without searching when OwnBook is on and a book is loaded.
+    bool ownBook_ = false;
+    Polyglot::Book book_;
+    std::mt19937_64 random_{std::random_device{}()};
+
+    Syzygy::Tablebases tablebases_;
+
+    // "go infinite" must not report its move before "stop", even when the search ends by itself.
+    std::mutex stopMutex_;
+    std::condition_variable stopCv_;
+    bool stopRequested_ = false;
+};
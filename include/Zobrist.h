@@ -0,0 +1,19 @@
+#pragma once
+#include "Bitboard.h"
+#include "Piece.h"
+#include <cstdint>
+
+// Random keys for incremental 64-bit position hashing. A position key is the XOR of the keys of
+// its pieces, the side to move (black only), its castling rights and its en-passant file.
+namespace Zobrist {
+
+extern uint64_t PieceSquare[PIECE_CODE_NB][64];
+extern uint64_t SideToMove;
+// Indexed by the full 4-bit castling rights mask.
+extern uint64_t Castling[16];
+extern uint64_t EnPassantFile[8];
+
+// Fill the key tables from a fixed seed. Called once from a static initializer in zobrist.cpp.
+void init();
+
+} // namespace Zobrist
@@ -1,33 +1,57 @@
 #pragma once
 #include "Piece.h"
-#include <vector>
-#include <optional>
+#include "Bitboard.h"
+#include "Move.h"
+#include "Zobrist.h"
+#include "Psqt.h"
+#include "PackedPosition.h"
 #include <vector>
 #include <array>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <cctype>
 
-struct Move {
-    Position from;
-    Position to;
-    Promotion promotion = Promotion::None;
-    bool isCapture : 1;
-    bool isEnpassant : 1;
-    bool isCastling : 1;
+// Castling rights bitmask as returned by Board::getCastlingRights().
+enum CastlingRight : uint8_t {
+    WHITE_OO = 1,
+    WHITE_OOO = 2,
+    BLACK_OO = 4,
+    BLACK_OOO = 8,
+    ALL_CASTLING = 15
+};
+
+// State needed to take back one move; pushed by makeMove and popped by unmakeMove.
+struct UndoInfo {
+    uint64_t key;
+    uint64_t pawnKey;
+    Move move;
+    PieceCode moved;
+    PieceCode captured;
+    uint8_t castling;
+    uint8_t epSquare;
+    uint16_t halfmoveClock;
+};
+
+// Why and where a FEN string was rejected by Board::setFEN.
+struct FenError {
+    const char* message = nullptr; // static text, nullptr when there is no error
+    size_t offset = 0;             // byte offset into the string
+
+    explicit operator bool() const { return message != nullptr; }
 };
 
 class Board {
 public:
+    // Longest FEN toFEN() writes, including the terminating zero, with counters up to 99999.
+    static constexpr size_t FEN_BUFFER_SIZE = 96;
+
     // Construct an empty board or load from a FEN string when provided.
-    // If `fen` is empty, startTurn is used to set side to move and the board is empty.
-    Board(PieceColor startTurn = PieceColor::White, const std::string& fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
-    : turn_(startTurn)
-    , board_{}
-    , en_passant_target_{-1, -1}
-    {
-        if (!fen.empty()) parseFEN(fen);
-    }
+    // If `fen` is empty, startTurn is used to set side to move and the board is empty. An invalid
+    // `fen` is reported on stderr and also leaves the board empty; use setFEN() to handle the error.
+    // A board without the side to move's king can be queried and have pieces placed on it, but
+    // it has no legal moves, is never in check and must not be searched or evaluated.
+    Board(PieceColor startTurn = PieceColor::White, std::string_view fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 
     ~Board() = default;
 
@@ -35,24 +59,101 @@ public:
         return p.row >= 0 && p.row < 8 && p.col >= 0 && p.col < 8;
     }
 
-    Piece* getPiece(const Position& p) {
+    const Piece* getPiece(const Position& p) const {
         if (!inBounds(p)) return nullptr;
-        auto& opt = board_[p.row][p.col];
-        return opt ? &*opt : nullptr;
+        PieceCode code = squares_[toSquare(p)];
+        return code ? &PIECES[code] : nullptr;
     }
 
-    const Piece* getPiece(const Position& p) const {
-        if (!inBounds(p)) return nullptr;
-        const auto& opt = board_[p.row][p.col];
-        return opt ? &*opt : nullptr;
+    // Bitboard views of the position
+    Bitboard occupied() const { return by_type_[0]; }
+    Bitboard pieces(PieceColor c) const { return by_color_[static_cast<int>(c)]; }
+    Bitboard pieces(PieceType t) const { return by_type_[static_cast<int>(t)]; }
+    Bitboard pieces(PieceType t, PieceColor c) const { return by_type_[static_cast<int>(t)] & by_color_[static_cast<int>(c)]; }
+    PieceCode pieceOn(Square sq) const { return squares_[sq]; }
+    Square kingSquare(PieceColor c) const {
+        Bitboard k = pieces(PieceType::King, c);
+        return k ? lsb(k) : NO_SQUARE;
     }
 
     PieceColor getTurn() const { return turn_; }
     void switchTurn() { turn_ = turn_ == PieceColor::White ? PieceColor::Black : PieceColor::White; }
 
-    Position enPassantTarget() const { return en_passant_target_; }
+    // En-passant target square, or (-1, -1) when there is none.
+    Position enPassantTarget() const {
+        return ep_square_ == NO_SQUARE ? Position(-1, -1) : toPosition(ep_square_);
+    }
+    Square enPassantSquare() const { return ep_square_; }
+
+    // Bitmask of CastlingRight values still available.
+    uint8_t getCastlingRights() const { return castling_; }
+
+    int halfmoveClock() const { return halfmove_clock_; }
+    // Move number as in FEN: starts at 1 and goes up after each black move.
+    int fullmoveNumber() const { return 1 + (game_ply_ - (turn_ == PieceColor::Black)) / 2; }
+
+    // Zobrist key of the position, and of its pawns alone.
+    uint64_t key() const { return key_; }
+    uint64_t pawnKey() const { return pawn_key_; }
+    // Material signature: the number of pawns, knights, bishops, rooks and queens of each side,
+    // MATERIAL_BITS bits per count, white's pawns lowest and black's queens highest. Equal for
+    // all positions with the same material and free of collisions.
+    static constexpr int MATERIAL_BITS = 6;
+    uint64_t materialKey() const {
+        uint64_t signature = 0;
+        for (int c = 0; c < 2; c++)
+            for (int t = 1; t <= 5; t++)
+                signature |= static_cast<uint64_t>(popcount(by_type_[t] & by_color_[c + 1])) << (MATERIAL_BITS * (c * 5 + t - 1));
+        return signature;
+    }
+    // Sum of Psqt::Table over all pieces, white's point of view.
+    Score psqScore() const { return psq_; }
+    // Sum of Psqt::PHASE_WEIGHT over all pieces; Psqt::MAX_PHASE at the start, 0 with only
+    // kings and pawns left. Can exceed MAX_PHASE after promotions.
+    int gamePhase() const { return phase_; }
+    // Moves made since the position was set up, oldest first; history()[i].key is the key of
+    // the position before move i.
+    const std::vector<UndoInfo>& history() const { return history_; }
+
+    // True if the current position occurred at least `times` times before, looking back only
+    // as far as the last capture or pawn move. isRepetition(2) is a threefold repetition.
+    bool isRepetition(int times = 1) const;
+
+    // Whether the side to move has a legal move. Returns on the first one found, so it is much
+    // cheaper than generating the move list to see if it is empty.
+    bool hasAnyLegalMove() const;
+    bool isCheckmate() const { return checkers() && !hasAnyLegalMove(); }
+    bool isStalemate() const { return !checkers() && !hasAnyLegalMove(); }
+    // Neither side has the material to mate: bare kings, a single minor piece, or only bishops
+    // all on squares of one color.
+    bool hasInsufficientMaterial() const;
+    // Drawn by rule: the fifty-move rule (unless the hundredth half-move mated), threefold
+    // repetition or insufficient material. Stalemate is left to isStalemate().
+    bool isDraw() const {
+        return hasInsufficientMaterial() || isRepetition(2) || (halfmove_clock_ >= 100 && !isCheckmate());
+    }
+
+    // Set up the position of a FEN string, dropping the move history. The halfmove clock and
+    // fullmove number may be left out and default to 0 and 1. Nothing is allocated. On error the
+    // board is left unchanged and, if given, `error` says what is wrong and where.
+    // With `end` given, text may follow the fields (as in EPD) and `end` receives the offset
+    // just past the last field read; otherwise only whitespace may follow.
+    bool setFEN(std::string_view fen, FenError* error = nullptr, size_t* end = nullptr);
+
+    // Write the FEN of the position into `out`, zero-terminated, and return its length; returns
+    // 0 and writes nothing if it does not fit in `size` bytes (FEN_BUFFER_SIZE always does).
+    size_t toFEN(char* out, size_t size) const;
+    std::string toFEN() const {
+        char buffer[FEN_BUFFER_SIZE];
+        return std::string(buffer, toFEN(buffer, sizeof(buffer)));
+    }
 
-    const bool* getCastlingRights() const { return castling_rights_; }
+    // Store the position in `out`, leaving its score, move and result empty. Fails only for
+    // boards of more than 32 pieces, which setFEN accepts but the format has no room for.
+    bool pack(PackedPosition& out) const;
+    // Set up a position stored by pack(), dropping the move history. Checked like setFEN: on a
+    // corrupt record the board is left unchanged and false returned.
+    bool unpack(const PackedPosition& packed);
 
     // Return an ASCII representation of the board: ranks 8->1, files a->h
     // Example:
@@ -66,12 +167,12 @@ public:
             int dispRank = 8 - row;
             os << dispRank << ' ';
             for (int col = 0; col < 8; ++col) {
-                const auto& opt = board_[row][col];
-                if (!opt) {
+                PieceCode code = squares_[makeSquare(row, col)];
+                if (!code) {
                     os << '.';
                 } else {
                     char ch = '?';
-                    switch (opt->type()) {
+                    switch (typeOf(code)) {
                         case PieceType::Pawn:   ch = 'p'; break;
                         case PieceType::Knight: ch = 'n'; break;
                         case PieceType::Bishop: ch = 'b'; break;
@@ -80,7 +181,7 @@ public:
                         case PieceType::King:   ch = 'k'; break;
                         default: ch = '?'; break;
                     }
-                    if (opt->color() == PieceColor::White) ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+                    if (colorOf(code) == PieceColor::White) ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
                     os << ch;
                 }
                 if (col < 7) os << ' ';
@@ -91,10 +192,14 @@ public:
         return os.str();
     }
 
+    // Make the legal move going from move.from() to move.to(), if there is one. Only the squares
+    // of `move` are matched; a promotion picks the queen unless `move` asks for another piece.
     bool tryMakeMove(const Move& move) {
-        std::vector<Move> legal = legalMovesFrom(move.from);
+        MoveList legal;
+        legalMoves(legal);
         for (const auto& m : legal) {
-            if (m.from == move.from && m.to == move.to) {
+            if (m.from() == move.from() && m.to() == move.to()
+                && (!move.isPromotion() || m.promotion() == move.promotion())) {
                 // Apply the canonical legal move so we preserve flags (promotion, en-passant, castling)
                 makeMove(m);
                 return true;
@@ -103,169 +208,123 @@ public:
         return false;
     }
 
-    void makeMove(const Move& move) {
-        // Ensure there is a piece to move (caller should have validated this)
-        if (!inBounds(move.from) || !inBounds(move.to)) return;
-        if (!board_[move.from.row][move.from.col]) return;
+    // Apply `move` and push the state needed to take it back. The move must come from the
+    // generator (or at least carry correct capture/en-passant/castling/promotion flags).
+    void makeMove(const Move& move);
+    // Take back the last move made with makeMove, restoring the position exactly.
+    void unmakeMove();
 
-        // Copy the moving piece so we can inspect its type/color before we change the board
-        Piece movingPiece = *board_[move.from.row][move.from.col];
+    // Whether `move`, which may come from another position (a hash move or a killer), is a
+    // pseudo-legal move here: the side to move's piece on its from square can make it, with the
+    // flags the generator would give it. Null moves are not.
+    bool isPseudoLegal(Move move) const;
 
-        // Handle en-passant capture: the captured pawn sits on the same row as the mover's from.row
-        // and in the destination column (i.e. Position(from.row, to.col)).
-        if (move.isEnpassant) {
-            Position capturedPos(move.from.row, move.to.col);
-            if (inBounds(capturedPos)) board_[capturedPos.row][capturedPos.col].reset();
-        }
-
-        // castling handle
-        if (move.isCastling && movingPiece.type() == PieceType::King) {
-            int row = move.from.row;
-            if (move.to.col == 6) { // kingside
-                board_[row][5] = std::move(board_[row][7]);
-                board_[row][7].reset();
-            } else if (move.to.col == 2) { // queenside
-                board_[row][3] = std::move(board_[row][0]);
-                board_[row][0].reset();
-            }
-        }
+    // Whether a pseudo-legal move of the side to move (right piece, reachable target, castling
+    // right held and path empty) is legal: it does not leave the king in check and castling
+    // does not start in, pass through or end in check.
+    bool isLegal(Move move) const;
 
+    void legalMoves(MoveList& out) const;
+    // std::vector conveniences for the GUI
+    std::vector<Move> legalMoves() const;
+    std::vector<Move> legalMovesFrom(const Position& p) const;
 
-        // Move the piece
-        board_[move.to.row][move.to.col] = std::move(board_[move.from.row][move.from.col]);
-        board_[move.from.row][move.from.col].reset();
-
-        // Update en-passant target: if a pawn moved two squares, set the target to the square
-        // it passed over. Otherwise clear the en-passant target.
-        en_passant_target_ = Position(-1, -1);
-        if (movingPiece.type() == PieceType::Pawn) {
-            int delta = move.to.row - move.from.row;
-            if (delta == 2 || delta == -2) {
-                int dir = (movingPiece.color() == PieceColor::White) ? -1 : 1;
-                en_passant_target_ = Position(move.from.row + dir, move.from.col);
-            }
-        }
-
-        // Update castling rights
-        if (movingPiece.type() == PieceType::King && movingPiece.color() == PieceColor::White) {
-            castling_rights_[0] = false;
-            castling_rights_[1] = false;
-        }
-        if (movingPiece.type() == PieceType::King && movingPiece.color() == PieceColor::Black) {
-            castling_rights_[2] = false;
-            castling_rights_[3] = false;
-        }
-        if (movingPiece.type() == PieceType::Rook && movingPiece.color() == PieceColor::White) {
-            if (move.from.row == 7 && move.from.col == 0) castling_rights_[1] = false; // queenside
-            if (move.from.row == 7 && move.from.col == 7) castling_rights_[0] = false; // kingside
-        }
-        if (movingPiece.type() == PieceType::Rook && movingPiece.color() == PieceColor::Black) {
-            if (move.from.row == 0 && move.from.col == 0) castling_rights_[3] = false; // queenside
-            if (move.from.row == 0 && move.from.col == 7) castling_rights_[2] = false; // kingside
-        }
-        if (move.isCapture) {
-            if (move.to.row == 7 && move.to.col == 0) castling_rights_[1] = false;
-            if (move.to.row == 7 && move.to.col == 7) castling_rights_[0] = false;
-            if (move.to.row == 0 && move.to.col == 0) castling_rights_[3] = false;
-            if (move.to.row == 0 && move.to.col == 7) castling_rights_[2] = false;
-        }
+    bool isKingInCheck(PieceColor color) const {
+        Square king = kingSquare(color);
+        return king != NO_SQUARE && isSquareAttacked(king, opposite(color));
+    }
 
-        // promotion logic
+    // Pieces of either color attacking `sq`, with sliders seeing through `occupied`.
+    Bitboard attackersTo(Square sq, Bitboard occupied) const {
+        using namespace Bitboards;
+        return (pawnAttacks(PieceColor::Black, sq) & pieces(PieceType::Pawn, PieceColor::White))
+             | (pawnAttacks(PieceColor::White, sq) & pieces(PieceType::Pawn, PieceColor::Black))
+             | (KnightAttacks[sq] & pieces(PieceType::Knight))
+             | (bishopAttacks(sq, occupied) & (pieces(PieceType::Bishop) | pieces(PieceType::Queen)))
+             | (rookAttacks(sq, occupied) & (pieces(PieceType::Rook) | pieces(PieceType::Queen)))
+             | (KingAttacks[sq] & pieces(PieceType::King));
+    }
 
-        if (move.promotion != Promotion::None) {
-            auto& old = board_[move.to.row][move.to.col];
-            if (old) {
-                Piece promoted(PieceType::Queen, old.value().color());
-                old = promoted;
-            }
-        }
+    // Pieces of color `by` attacking `sq` in the current position.
+    Bitboard attackersTo(Square sq, PieceColor by) const {
+        return attackersTo(sq, occupied()) & pieces(by);
+    }
 
-        // Switch side to move
-        turn_ = (turn_ == PieceColor::White) ? PieceColor::Black : PieceColor::White;
+    bool isSquareAttacked(Square sq, PieceColor by) const {
+        return attackersTo(sq, by) != 0;
     }
 
-    std::vector<Move> legalMoves() const;
-    std::vector<Move> legalMovesFrom(const Position& p) const;
+    // Enemy pieces giving check to the side to move; none if it has no king.
+    Bitboard checkers() const {
+        const Square king = kingSquare(turn_);
+        return king == NO_SQUARE ? 0 : attackersTo(king, opposite(turn_));
+    }
 
-    bool isKingInCheck(PieceColor color) const;
+    // Pieces of either color that are the only piece between the king of color `c` and an enemy
+    // slider. Own blockers are pinned; enemy blockers would give discovered check by moving.
+    // None if that king is missing.
+    Bitboard blockersForKing(PieceColor c) const;
 
 private:
+    // Shared Piece objects handed out by getPiece(), indexed by PieceCode.
+    static const Piece PIECES[PIECE_CODE_NB];
+
     PieceColor turn_;
-    std::array<std::array<std::optional<Piece>, 8>, 8> board_;
-    Position en_passant_target_;
-
-    // int halfmove_clock_ = 0;
-    // Castling rights: [white kingside, white queenside, black kingside, black queenside]
-    bool castling_rights_[4] = {true, true, true, true};
-    // Track en passant target square (-1, -1 if none)
-    // std::pair<int, int> en_passant_target_ = {-1, -1};
-
-    void parseFEN(const std::string& fen) {
-        // clear board
-        for (int r = 0; r < 8; ++r)
-            for (int c = 0; c < 8; ++c)
-                board_[r][c].reset();
-
-        std::istringstream iss(fen);
-        std::string placement, side, castling, enpass;
-        if (!(iss >> placement)) return;
-        iss >> side;
-        if (!(iss >> castling)) castling = "-";
-        if (!(iss >> enpass)) enpass = "-";
-
-        // parse placement: ranks separated by '/'
-        std::vector<std::string> ranks;
-        {
-            std::istringstream ps(placement);
-            std::string rank;
-            while (std::getline(ps, rank, '/')) ranks.push_back(rank);
-        }
-        if (ranks.size() != 8) return;
-
-        for (int rr = 0; rr < 8; ++rr) {
-            const std::string& rank = ranks[rr];
-            int row = rr; // ranks[0] is rank 8 -> row 0
-            int col = 0;
-            for (char ch : rank) {
-                if (std::isdigit(static_cast<unsigned char>(ch))) {
-                    col += ch - '0';
-                } else {
-                    PieceColor color = std::isupper(static_cast<unsigned char>(ch)) ? PieceColor::White : PieceColor::Black;
-                    char lower = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
-                    PieceType type = PieceType::None;
-                    switch (lower) {
-                        case 'p': type = PieceType::Pawn; break;
-                        case 'n': type = PieceType::Knight; break;
-                        case 'b': type = PieceType::Bishop; break;
-                        case 'r': type = PieceType::Rook; break;
-                        case 'q': type = PieceType::Queen; break;
-                        case 'k': type = PieceType::King; break;
-                        default: type = PieceType::None; break;
-                    }
-                    if (type != PieceType::None && col >= 0 && col < 8 && row >= 0 && row < 8) {
-                        board_[row][col] = Piece(type, color);
-                    }
-                    ++col;
-                }
-            }
-        }
+    // by_type_[0] holds every occupied square, by_type_[t] the squares of piece type t.
+    Bitboard by_type_[7];
+    // Indexed by PieceColor; [0] is unused.
+    Bitboard by_color_[3];
+    std::array<PieceCode, 64> squares_;
+    Square ep_square_ = NO_SQUARE;
+    int halfmove_clock_ = 0;
+    // Half-moves since the start of the game, counted from the FEN's fullmove number.
+    int game_ply_ = 0;
+    uint8_t castling_ = 0; // set by setFEN and unpack
+    uint64_t key_ = 0;
+    uint64_t pawn_key_ = 0;
+    // Evaluation terms kept up to date by putPiece, removePiece and movePiece.
+    Score psq_ = 0;
+    int phase_ = 0;
+    std::vector<UndoInfo> history_;
+
+    // Replace the position with a checked one, dropping the move history.
+    void setPosition(const std::array<PieceCode, 64>& squares, PieceColor turn, uint8_t castling,
+                     Square ep, int halfmoveClock, int fullmoveNumber);
+    // Recompute key_ and pawn_key_ from scratch; only used when a position is set up.
+    void computeKeys();
+    // Set the en-passant square after a double push only if an enemy pawn could capture there,
+    // so positions that differ only by an unusable en-passant square hash the same.
+    void setEnPassant(Square sq, PieceColor capturer);
+
+    void putPiece(Square sq, PieceCode code) {
+        Bitboard b = squareBB(sq);
+        squares_[sq] = code;
+        by_type_[0] |= b;
+        by_type_[code & 7] |= b;
+        by_color_[code >> 3] |= b;
+        psq_ += Psqt::Table[code][sq];
+        phase_ += Psqt::PHASE_WEIGHT[code & 7];
+    }
 
-        // side to move
-        if (!side.empty() && side[0] == 'b') turn_ = PieceColor::Black; else turn_ = PieceColor::White;
-
-        // en-passant target
-        if (enpass == "-") {
-            en_passant_target_ = Position(-1, -1);
-        } else if (enpass.size() >= 2) {
-            char file = enpass[0];
-            char rankch = enpass[1];
-            int col = file - 'a';
-            int rank = rankch - '0';
-            int row = 8 - rank; // rank 8 -> row 0
-            if (row >= 0 && row < 8 && col >= 0 && col < 8) en_passant_target_ = Position(row, col);
-            else en_passant_target_ = Position(-1, -1);
-        } else {
-            en_passant_target_ = Position(-1, -1);
-        }
+    void removePiece(Square sq) {
+        Bitboard b = squareBB(sq);
+        PieceCode code = squares_[sq];
+        squares_[sq] = 0;
+        by_type_[0] &= ~b;
+        by_type_[code & 7] &= ~b;
+        by_color_[code >> 3] &= ~b;
+        psq_ -= Psqt::Table[code][sq];
+        phase_ -= Psqt::PHASE_WEIGHT[code & 7];
+    }
+
+    void movePiece(Square from, Square to) {
+        Bitboard b = squareBB(from) | squareBB(to);
+        PieceCode code = squares_[from];
+        squares_[from] = 0;
+        squares_[to] = code;
+        by_type_[0] ^= b;
+        by_type_[code & 7] ^= b;
+        by_color_[code >> 3] ^= b;
+        psq_ += Psqt::Table[code][to] - Psqt::Table[code][from];
     }
 };
@@ -0,0 +1,83 @@
+#include "Analyzer.h"
+
+#include <algorithm>
+
+Analyzer::Analyzer(size_t hashMB, int threads)
+: tt_(hashMB)
+, search_(tt_, threads)
+{
+    // Called on the search's main thread, the only producer of updates_. A full queue means the
+    // UI is not reading; dropping reports is better than slowing the search down.
+    search_.onInfo = [this](const SearchInfo& info) {
+        AnalysisUpdate update;
+        update.depth = info.depth;
+        update.score = info.score;
+        update.nodes = info.nodes;
+        update.pvLength = std::min(static_cast<int>(info.pv.size()), AnalysisUpdate::MAX_PV);
+        std::copy(info.pv.begin(), info.pv.begin() + update.pvLength, update.pv);
+        update.key = currentKey_.load(std::memory_order_relaxed);
+        updates_.push(update);
+    };
+    thread_ = std::thread([this] { threadMain(); });
+}
+
+Analyzer::~Analyzer() {
+    quit_.store(true, std::memory_order_relaxed);
+    requestCount_.fetch_add(1, std::memory_order_release);
+    requestCount_.notify_one();
+    thread_.join();
+}
+
+void Analyzer::analyze(const Board& board) {
+    submit(Request{true, board});
+}
+
+void Analyzer::pause() {
+    submit(Request{false, Board()});
+}
+
+void Analyzer::submit(Request request) {
+    // Requests are only ever superseded, so an older pending one can be dropped.
+    pending_ = std::move(request);
+    if (!requests_.push(std::move(*pending_))) return;
+    pending_.reset();
+    requestCount_.fetch_add(1, std::memory_order_release);
+    requestCount_.notify_one();
+}
+
+bool Analyzer::poll(AnalysisUpdate& update) {
+    if (pending_) {
+        // submit() assigns pending_, so the request must leave it first.
+        Request request = std::move(*pending_);
+        pending_.reset();
+        submit(std::move(request));
+    }
+    return updates_.pop(update);
+}
+
+void Analyzer::threadMain() {
+    while (true) {
+        const uint32_t seen = requestCount_.load(std::memory_order_acquire);
+        if (quit_.load(std::memory_order_relaxed)) break;
+
+        // Only the newest request matters. The count may already be past `seen` for requests
+        // taken here; the wait below then returns at once and finds the queue empty.
+        Request request;
+        bool any = false;
+        while (requests_.pop(request)) any = true;
+        if (any) {
+            search_.stop();
+            search_.wait();
+            if (request.active) {
+                currentKey_.store(request.board.key(), std::memory_order_relaxed);
+                SearchLimits limits;
+                limits.infinite = true;
+                search_.start(request.board, limits, [](const SearchResult&) {});
+            }
+        }
+
+        requestCount_.wait(seen, std::memory_order_acquire);
+    }
+    search_.stop();
+    search_.wait();
+}
@@ -0,0 +1,210 @@
+#include "Batch.h"
+#include "Epd.h"
+#include "Evaluate.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A run of whole lines of the input, analysed by one thread.
+struct Chunk {
+    std::string_view text;
+    // Line numbers relative to the chunk until the writer adds the lines before it.
+    std::vector<BatchResult> results;
+    size_t lines = 0;
+    bool done = false;
+};
+
+std::vector<Chunk> makeChunks(std::string_view text, size_t size) {
+    std::vector<Chunk> chunks;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = pos + std::max<size_t>(size, 1);
+        if (end >= text.size()) {
+            end = text.size();
+        } else {
+            end = text.find('\n', end);
+            end = end == std::string_view::npos ? text.size() : end + 1;
+        }
+        chunks.push_back(Chunk{text.substr(pos, end - pos), {}, 0, false});
+        pos = end;
+    }
+    return chunks;
+}
+
+// One thread's reusable state: the position being read and, when searching, its own search.
+class Worker {
+public:
+    explicit Worker(const BatchOptions& options)
+    : options_(options)
+    {
+        if (options.depth > 0) {
+            tt_ = std::make_unique<TranspositionTable>(options.hashMB);
+            search_ = std::make_unique<Search>(*tt_);
+            search_->setNetwork(options.network);
+        }
+    }
+
+    void analyze(Chunk& chunk) {
+        EpdReader reader(chunk.text);
+        chunk.results.reserve(chunk.text.size() / 48);
+        while (reader.next(entry_)) {
+            BatchResult result;
+            result.line = entry_.lineNumber;
+            if (!entry_.error) analyzePosition(entry_.board, result);
+            chunk.results.push_back(result);
+        }
+        chunk.lines = reader.lineNumber();
+    }
+
+private:
+    void analyzePosition(const Board& board, BatchResult& result) {
+        MoveList moves;
+        board.legalMoves(moves);
+        bool check = board.checkers() != 0;
+        result.legalMoves = static_cast<uint8_t>(moves.size());
+        if (moves.empty()) result.status = check ? BatchStatus::Checkmate : BatchStatus::Stalemate;
+        else result.status = check ? BatchStatus::Check : BatchStatus::Normal;
+        result.eval = static_cast<int16_t>(options_.network ? options_.network->evaluate(board) : evaluate(board));
+
+        if (search_ && !moves.empty()) {
+            SearchLimits limits;
+            limits.depth = options_.depth;
+            SearchResult found = search_->run(board, limits);
+            result.score = static_cast<int16_t>(found.score);
+            result.bestMove = found.bestMove.raw();
+        }
+    }
+
+    const BatchOptions& options_;
+    EpdEntry entry_;
+    std::unique_ptr<TranspositionTable> tt_;
+    std::unique_ptr<Search> search_;
+};
+
+const char* statusName(BatchStatus status) {
+    switch (status) {
+        case BatchStatus::Normal: return "normal";
+        case BatchStatus::Check: return "check";
+        case BatchStatus::Checkmate: return "checkmate";
+        case BatchStatus::Stalemate: return "stalemate";
+        default: return "invalid";
+    }
+}
+
+void appendNumber(std::string& out, int64_t value) {
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, end);
+}
+
+void writeCsv(const std::vector<BatchResult>& results, bool searched, std::string& buffer, std::ostream& out) {
+    buffer.clear();
+    for (const BatchResult& r : results) {
+        appendNumber(buffer, static_cast<int64_t>(r.line));
+        buffer += ',';
+        buffer += statusName(r.status);
+        buffer += ',';
+        if (r.status != BatchStatus::Invalid) {
+            appendNumber(buffer, r.legalMoves);
+            buffer += ',';
+            appendNumber(buffer, r.eval);
+        } else {
+            buffer += ',';
+        }
+        buffer += ',';
+        if (searched && r.bestMove) {
+            buffer += toUci(Move::fromRaw(r.bestMove));
+            buffer += ',';
+            appendNumber(buffer, r.score);
+        } else {
+            buffer += ',';
+        }
+        buffer += '\n';
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+} // namespace
+
+BatchStats analyzeBatch(std::string_view text, const BatchOptions& options, std::ostream& out) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Chunk> chunks = makeChunks(text, options.chunkBytes);
+    const int threads = std::max(1, options.threads);
+    // Chunks may be finished at most this far ahead of the one being written, which bounds the
+    // memory held by results waiting for their turn.
+    const size_t window = 4 * static_cast<size_t>(threads);
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t nextChunk = 0;
+    size_t written = 0;
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back([&] {
+            Worker worker(options);
+            while (true) {
+                size_t index;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&] { return nextChunk == chunks.size() || nextChunk < written + window; });
+                    if (nextChunk == chunks.size()) return;
+                    index = nextChunk++;
+                }
+                worker.analyze(chunks[index]);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    chunks[index].done = true;
+                }
+                changed.notify_all();
+            }
+        });
+    }
+
+    BatchStats stats;
+    if (options.format == BatchFormat::Csv) out << "line,status,legal_moves,eval,best_move,score\n";
+    std::string buffer;
+    uint64_t lineBase = 0;
+    while (written < chunks.size()) {
+        Chunk& chunk = chunks[written];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return chunk.done; });
+        }
+
+        for (BatchResult& r : chunk.results) {
+            r.line += lineBase;
+            if (r.status == BatchStatus::Invalid) stats.invalid++;
+        }
+        lineBase += chunk.lines;
+        stats.positions += chunk.results.size();
+        if (options.format == BatchFormat::Csv) {
+            writeCsv(chunk.results, options.depth > 0, buffer, out);
+        } else {
+            out.write(reinterpret_cast<const char*>(chunk.results.data()),
+                      static_cast<std::streamsize>(chunk.results.size() * sizeof(BatchResult)));
+        }
+        std::vector<BatchResult>().swap(chunk.results);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written++;
+        }
+        changed.notify_all();
+    }
+
+    for (auto& t : pool) t.join();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
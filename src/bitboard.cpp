@@ -0,0 +1,119 @@
+#include "Bitboard.h"
+
+namespace Bitboards {
+
+Magic BishopMagics[64];
+Magic RookMagics[64];
+
+namespace {
+
+// Shared slider tables. The sizes are the sum over all squares of 2^(relevant mask bits).
+Bitboard BishopTable[0x1480];
+Bitboard RookTable[0x19000];
+
+// Reference ray walk, only used to fill the lookup tables.
+Bitboard slidingAttacks(Square sq, Bitboard occupied, const int (*dirs)[2]) {
+    Bitboard attacks = 0;
+    for (int i = 0; i < 4; i++) {
+        int r = rankOf(sq) + dirs[i][0];
+        int f = fileOf(sq) + dirs[i][1];
+        while (r >= 0 && r < 8 && f >= 0 && f < 8) {
+            Bitboard b = squareBB(r * 8 + f);
+            attacks |= b;
+            if (occupied & b) break;
+            r += dirs[i][0];
+            f += dirs[i][1];
+        }
+    }
+    return attacks;
+}
+
+constexpr int BISHOP_DIRS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+constexpr int ROOK_DIRS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+// xorshift64* generator; fixed seeds keep magic discovery deterministic and fast.
+class PRNG {
+public:
+    explicit PRNG(uint64_t seed) : s_(seed) {}
+
+    uint64_t rand64() {
+        s_ ^= s_ >> 12;
+        s_ ^= s_ << 25;
+        s_ ^= s_ >> 27;
+        return s_ * 2685821657736338717ULL;
+    }
+
+    // Candidates with few set bits make good magics.
+    uint64_t sparseRand() { return rand64() & rand64() & rand64(); }
+
+private:
+    uint64_t s_;
+};
+
+void initMagics(Bitboard* table, Magic* magics, const int (*dirs)[2]) {
+#ifndef CHESS_USE_PEXT
+    // Seeds per rank that find all magics quickly.
+    static const uint64_t seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+    static Bitboard occupancy[4096];
+    int epoch[4096] = {};
+    int attempt = 0;
+#endif
+    static Bitboard reference[4096];
+
+    int size = 0;
+    for (Square sq = 0; sq < 64; sq++) {
+        // Board edges are not relevant unless the slider itself sits on that edge.
+        Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~rankBB(sq)) | ((FILE_A_BB | FILE_H_BB) & ~fileBB(sq));
+
+        Magic& m = magics[sq];
+        m.mask = slidingAttacks(sq, 0, dirs) & ~edges;
+        m.shift = 64 - popcount(m.mask);
+        m.attacks = sq == 0 ? table : magics[sq - 1].attacks + size;
+
+        // Enumerate every subset of the mask (Carry-Rippler) with its attack set.
+        Bitboard b = 0;
+        size = 0;
+        do {
+            reference[size] = slidingAttacks(sq, b, dirs);
+#ifdef CHESS_USE_PEXT
+            m.attacks[_pext_u64(b, m.mask)] = reference[size];
+#else
+            occupancy[size] = b;
+#endif
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+#ifndef CHESS_USE_PEXT
+        // Try random sparse candidates until one maps every subset without destructive collisions.
+        PRNG rng(seeds[rankOf(sq)]);
+        for (int i = 0; i < size;) {
+            for (m.magic = 0; popcount((m.magic * m.mask) >> 56) < 6;) m.magic = rng.sparseRand();
+
+            ++attempt;
+            for (i = 0; i < size; i++) {
+                unsigned idx = m.index(occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+struct Initializer {
+    Initializer() { init(); }
+} initializer;
+
+} // namespace
+
+void init() {
+    initMagics(BishopTable, BishopMagics, BISHOP_DIRS);
+    initMagics(RookTable, RookMagics, ROOK_DIRS);
+}
+
+} // namespace Bitboards
@@ -1,53 +1,622 @@
 #include "board.h"
 #include "MoveGenerator.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <vector>
 
-std::vector<Move> Board::legalMoves() const {
-    std::vector<Move> pseudo;
-    MoveGenerator::generateAll(*this, pseudo);
-    std::vector<Move> legal;
-    legal.reserve(pseudo.size());
-    for (auto& m : pseudo) {
-        Board copy = *this; // or use makeMove/undoMove for performance
-        copy.makeMove(m);
-        if (!copy.isKingInCheck(turn_)) legal.push_back(m);
+const Piece Board::PIECES[PIECE_CODE_NB] = {
+    {PieceType::None, PieceColor::None},
+    {PieceType::Pawn, PieceColor::None},
+    {PieceType::Knight, PieceColor::None},
+    {PieceType::Bishop, PieceColor::None},
+    {PieceType::Rook, PieceColor::None},
+    {PieceType::Queen, PieceColor::None},
+    {PieceType::King, PieceColor::None},
+    {PieceType::None, PieceColor::None},
+    {PieceType::None, PieceColor::White},
+    {PieceType::Pawn, PieceColor::White},
+    {PieceType::Knight, PieceColor::White},
+    {PieceType::Bishop, PieceColor::White},
+    {PieceType::Rook, PieceColor::White},
+    {PieceType::Queen, PieceColor::White},
+    {PieceType::King, PieceColor::White},
+    {PieceType::None, PieceColor::White},
+    {PieceType::None, PieceColor::Black},
+    {PieceType::Pawn, PieceColor::Black},
+    {PieceType::Knight, PieceColor::Black},
+    {PieceType::Bishop, PieceColor::Black},
+    {PieceType::Rook, PieceColor::Black},
+    {PieceType::Queen, PieceColor::Black},
+    {PieceType::King, PieceColor::Black},
+    {PieceType::None, PieceColor::Black},
+};
+
+namespace {
+
+// Castling rights kept when a piece moves from or to each square: touching a king or rook home
+// square drops the matching rights.
+constexpr std::array<uint8_t, 64> CASTLING_MASK = [] {
+    std::array<uint8_t, 64> mask{};
+    mask.fill(ALL_CASTLING);
+    mask[makeSquare(7, 4)] &= ~(WHITE_OO | WHITE_OOO);
+    mask[makeSquare(7, 7)] &= ~WHITE_OO;
+    mask[makeSquare(7, 0)] &= ~WHITE_OOO;
+    mask[makeSquare(0, 4)] &= ~(BLACK_OO | BLACK_OOO);
+    mask[makeSquare(0, 7)] &= ~BLACK_OO;
+    mask[makeSquare(0, 0)] &= ~BLACK_OOO;
+    return mask;
+}();
+
+// FEN letter of each PieceCode.
+constexpr char PIECE_CHARS[PIECE_CODE_NB + 1] = " pnbrqk  PNBRQK  pnbrqk ";
+
+PieceCode pieceFromChar(char ch) {
+    switch (ch) {
+        case 'P': return makePieceCode(PieceType::Pawn, PieceColor::White);
+        case 'N': return makePieceCode(PieceType::Knight, PieceColor::White);
+        case 'B': return makePieceCode(PieceType::Bishop, PieceColor::White);
+        case 'R': return makePieceCode(PieceType::Rook, PieceColor::White);
+        case 'Q': return makePieceCode(PieceType::Queen, PieceColor::White);
+        case 'K': return makePieceCode(PieceType::King, PieceColor::White);
+        case 'p': return makePieceCode(PieceType::Pawn, PieceColor::Black);
+        case 'n': return makePieceCode(PieceType::Knight, PieceColor::Black);
+        case 'b': return makePieceCode(PieceType::Bishop, PieceColor::Black);
+        case 'r': return makePieceCode(PieceType::Rook, PieceColor::Black);
+        case 'q': return makePieceCode(PieceType::Queen, PieceColor::Black);
+        case 'k': return makePieceCode(PieceType::King, PieceColor::Black);
+        default: return 0;
     }
-    return legal;
 }
 
-std::vector<Move> Board::legalMovesFrom(const Position& p) const {
-    std::vector<Move> pseudo;
-    MoveGenerator::generateFrom(*this, p, pseudo);
-    std::vector<Move> legal;
-    legal.reserve(pseudo.size());
-    for (auto& m : pseudo) {
-        Board copy = *this; // or use makeMove/undoMove for performance
-        copy.makeMove(m);
-        if (!copy.isKingInCheck(turn_)) legal.push_back(m);
-    }
-    return legal;
-}
-
-bool Board::isKingInCheck(PieceColor color) const {
-        PieceColor opponent = color == PieceColor::White ? PieceColor::Black : PieceColor::White;
-        std::vector<Move> legal;
-        MoveGenerator::generateAllSide(*this, opponent, legal);
-
-        // find the king
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                Position pos(r, c);
-                const Piece* piece = getPiece(pos);
-                if (!piece || piece->color() != color || piece->type() != PieceType::King) continue;
-
-                // king found
-                for (const auto& m : legal) {
-                    if (m.to == pos) return true;
-                }
-                return false;
+// Whether the king and rook of castling right `right` stand on their home squares.
+bool castlingPiecesHome(const std::array<PieceCode, 64>& squares, uint8_t right) {
+    const PieceColor color = (right & (WHITE_OO | WHITE_OOO)) ? PieceColor::White : PieceColor::Black;
+    const int row = color == PieceColor::White ? 7 : 0;
+    const int rookCol = (right & (WHITE_OO | BLACK_OO)) ? 7 : 0;
+    return squares[makeSquare(row, 4)] == makePieceCode(PieceType::King, color)
+        && squares[makeSquare(row, rookCol)] == makePieceCode(PieceType::Rook, color);
+}
+
+// Whether `ep`, on the third rank of the side not to move, is the square one of its pawns just
+// passed over with a double push: empty, the pawn in front of it and its start square empty.
+bool enPassantPlausible(const std::array<PieceCode, 64>& squares, Square ep, PieceColor turn) {
+    const int up = turn == PieceColor::White ? 8 : -8;
+    return !squares[ep] && !squares[ep + up]
+        && squares[ep - up] == makePieceCode(PieceType::Pawn, opposite(turn));
+}
+
+bool isBlank(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+// Cursor over the fields of a FEN string.
+struct FenReader {
+    std::string_view text;
+    size_t pos = 0;
+    FenError* error;
+
+    bool fail(const char* message, size_t at) {
+        if (error) *error = FenError{message, at};
+        return false;
+    }
+
+    void skipBlanks() {
+        while (pos < text.size() && isBlank(text[pos])) pos++;
+    }
+
+    // The next whitespace-separated field; empty at the end of the text. A ';' also ends a
+    // field, for EPD operations written without a space before them.
+    std::string_view field() {
+        skipBlanks();
+        size_t start = pos;
+        while (pos < text.size() && !isBlank(text[pos]) && text[pos] != ';') pos++;
+        return text.substr(start, pos - start);
+    }
+
+    // True if the next field starts with a digit, so it can be a move counter.
+    bool counterFollows() {
+        skipBlanks();
+        return pos < text.size() && text[pos] >= '0' && text[pos] <= '9';
+    }
+};
+
+} // namespace
+
+Board::Board(PieceColor startTurn, std::string_view fen)
+    : turn_(startTurn)
+    , by_type_{}
+    , by_color_{}
+    , squares_{}
+{
+    history_.reserve(256);
+    if (fen.empty()) {
+        computeKeys();
+        return;
+    }
+    FenError error;
+    if (!setFEN(fen, &error)) {
+        std::fprintf(stderr, "invalid fen at offset %zu: %s: %.*s\n", error.offset, error.message,
+                     static_cast<int>(fen.size()), fen.data());
+        computeKeys();
+    }
+}
+
+bool Board::setFEN(std::string_view fen, FenError* error, size_t* end) {
+    FenReader in{fen, 0, error};
+
+    // Everything is checked before the board is touched, so a rejected FEN changes nothing.
+    std::array<PieceCode, 64> squares{};
+    std::string_view placement = in.field();
+    size_t at = in.pos - placement.size();
+    if (placement.empty()) return in.fail("missing piece placement", at);
+    int row = 0, col = 0;
+    int kings[3] = {};
+    for (size_t i = 0; i < placement.size(); i++) {
+        char ch = placement[i];
+        if (ch == '/') {
+            if (col != 8) return in.fail("rank does not have 8 squares", at + i);
+            if (++row == 8) return in.fail("more than 8 ranks", at + i);
+            col = 0;
+        } else if (ch >= '1' && ch <= '8') {
+            col += ch - '0';
+            if (col > 8) return in.fail("rank has more than 8 squares", at + i);
+        } else if (PieceCode code = pieceFromChar(ch)) {
+            if (col == 8) return in.fail("rank has more than 8 squares", at + i);
+            if (typeOf(code) == PieceType::Pawn && (row == 0 || row == 7))
+                return in.fail("pawn on the first or last rank", at + i);
+            if (typeOf(code) == PieceType::King) kings[static_cast<int>(colorOf(code))]++;
+            squares[makeSquare(row, col++)] = code;
+        } else {
+            return in.fail("unexpected character in piece placement", at + i);
+        }
+    }
+    if (row != 7 || col != 8) return in.fail("piece placement does not have 8 ranks of 8 squares", at + placement.size());
+    if (kings[static_cast<int>(PieceColor::White)] != 1 || kings[static_cast<int>(PieceColor::Black)] != 1)
+        return in.fail("each side needs exactly one king", at);
+
+    std::string_view side = in.field();
+    at = in.pos - side.size();
+    if (side != "w" && side != "b") return in.fail("side to move must be 'w' or 'b'", at);
+    PieceColor turn = side == "w" ? PieceColor::White : PieceColor::Black;
+
+    std::string_view castlingField = in.field();
+    at = in.pos - castlingField.size();
+    uint8_t castling = 0;
+    if (castlingField != "-") {
+        if (castlingField.empty()) return in.fail("missing castling rights", at);
+        for (size_t i = 0; i < castlingField.size(); i++) {
+            uint8_t right = 0;
+            switch (castlingField[i]) {
+                case 'K': right = WHITE_OO; break;
+                case 'Q': right = WHITE_OOO; break;
+                case 'k': right = BLACK_OO; break;
+                case 'q': right = BLACK_OOO; break;
+                default: return in.fail("castling rights must be '-' or letters of 'KQkq'", at + i);
+            }
+            if (castling & right) return in.fail("castling right given twice", at + i);
+            if (!castlingPiecesHome(squares, right))
+                return in.fail("castling right without its king and rook on their home squares", at + i);
+            castling |= right;
+        }
+    }
+
+    std::string_view epField = in.field();
+    at = in.pos - epField.size();
+    Square ep = NO_SQUARE;
+    if (epField != "-") {
+        int wantedRank = turn == PieceColor::White ? '6' : '3';
+        if (epField.size() != 2 || epField[0] < 'a' || epField[0] > 'h' || epField[1] != wantedRank)
+            return in.fail("en-passant square must be '-' or a square behind a pawn that just moved two squares", at);
+        ep = makeSquare(8 - (epField[1] - '0'), epField[0] - 'a');
+        if (!enPassantPlausible(squares, ep, turn))
+            return in.fail("en-passant square without a pawn that just moved two squares", at);
+    }
+
+    // The counters are optional, EPD leaves them out.
+    int counters[2] = {0, 1};
+    for (int& counter : counters) {
+        if (!in.counterFollows()) break;
+        std::string_view number = in.field();
+        at = in.pos - number.size();
+        auto [ptr, ec] = std::from_chars(number.data(), number.data() + number.size(), counter);
+        if (ec != std::errc() || ptr != number.data() + number.size())
+            return in.fail("move counter is not a number", at);
+    }
+    if (counters[1] < 1) return in.fail("fullmove number must be at least 1", at);
+
+    if (end) {
+        *end = in.pos;
+    } else {
+        in.skipBlanks();
+        if (in.pos != fen.size()) return in.fail("unexpected text after the FEN", in.pos);
+    }
+
+    setPosition(squares, turn, castling, ep, counters[0], counters[1]);
+    return true;
+}
+
+void Board::setPosition(const std::array<PieceCode, 64>& squares, PieceColor turn, uint8_t castling,
+                        Square ep, int halfmoveClock, int fullmoveNumber) {
+    for (auto& b : by_type_) b = 0;
+    for (auto& b : by_color_) b = 0;
+    squares_.fill(0);
+    psq_ = 0;
+    phase_ = 0;
+    history_.clear();
+    for (Square sq = 0; sq < 64; sq++)
+        if (squares[sq]) putPiece(sq, squares[sq]);
+
+    turn_ = turn;
+    castling_ = castling;
+    ep_square_ = NO_SQUARE;
+    if (ep != NO_SQUARE) setEnPassant(ep, turn_);
+    halfmove_clock_ = halfmoveClock;
+    game_ply_ = 2 * (fullmoveNumber - 1) + (turn_ == PieceColor::Black);
+    computeKeys();
+}
+
+bool Board::pack(PackedPosition& out) const {
+    const Bitboard occ = occupied();
+    if (popcount(occ) > 32) return false;
+
+    out = PackedPosition{};
+    out.occupied = occ;
+    int i = 0;
+    for (Bitboard b = occ; b; i++)
+        out.pieces[i / 2] |= static_cast<uint8_t>((squares_[popLsb(b)] - 8) << (4 * (i & 1)));
+
+    const uint32_t epFile = ep_square_ == NO_SQUARE ? 0 : fileOf(ep_square_) + 1;
+    const uint32_t halfmove = std::min(halfmove_clock_, PackedPosition::MAX_HALFMOVE_CLOCK);
+    const uint32_t fullmove = std::min(fullmoveNumber(), PackedPosition::MAX_FULLMOVE_NUMBER);
+    out.state = (turn_ == PieceColor::Black) | (castling_ << 1) | (epFile << 5) | (halfmove << 11) | (fullmove << 19);
+    return true;
+}
+
+bool Board::unpack(const PackedPosition& packed) {
+    if (popcount(packed.occupied) > 32) return false;
+
+    // Everything is checked before the board is touched, as in setFEN.
+    std::array<PieceCode, 64> squares{};
+    int kings[3] = {};
+    int i = 0;
+    for (Bitboard b = packed.occupied; b; i++) {
+        const Square sq = popLsb(b);
+        const int nibble = (packed.pieces[i / 2] >> (4 * (i & 1))) & 15;
+        const int type = nibble & 7;
+        if (type < static_cast<int>(PieceType::Pawn) || type > static_cast<int>(PieceType::King)) return false;
+        const PieceCode code = static_cast<PieceCode>(nibble + 8);
+        if (typeOf(code) == PieceType::Pawn && (squareBB(sq) & (RANK_1_BB | RANK_8_BB))) return false;
+        if (typeOf(code) == PieceType::King) kings[static_cast<int>(colorOf(code))]++;
+        squares[sq] = code;
+    }
+    if (kings[static_cast<int>(PieceColor::White)] != 1 || kings[static_cast<int>(PieceColor::Black)] != 1) return false;
+
+    const uint32_t state = packed.state;
+    const PieceColor turn = (state & 1) ? PieceColor::Black : PieceColor::White;
+    const uint8_t castling = (state >> 1) & ALL_CASTLING;
+    const int epFile = (state >> 5) & 15;
+    const int fullmove = static_cast<int>(state >> 19);
+    if (epFile > 8 || fullmove < 1) return false;
+    for (uint8_t right : {WHITE_OO, WHITE_OOO, BLACK_OO, BLACK_OOO})
+        if ((castling & right) && !castlingPiecesHome(squares, right)) return false;
+    // The square behind a pawn that just moved two squares.
+    const Square ep = epFile ? makeSquare(turn == PieceColor::White ? 2 : 5, epFile - 1) : NO_SQUARE;
+    if (ep != NO_SQUARE && !enPassantPlausible(squares, ep, turn)) return false;
+
+    setPosition(squares, turn, castling, ep, (state >> 11) & 255, fullmove);
+    return true;
+}
+
+size_t Board::toFEN(char* out, size_t size) const {
+    char buffer[FEN_BUFFER_SIZE];
+    char* p = buffer;
+    for (int row = 0; row < 8; row++) {
+        int empty = 0;
+        for (int col = 0; col < 8; col++) {
+            PieceCode code = squares_[makeSquare(row, col)];
+            if (!code) {
+                empty++;
+                continue;
+            }
+            if (empty) *p++ = static_cast<char>('0' + empty);
+            empty = 0;
+            *p++ = PIECE_CHARS[code];
+        }
+        if (empty) *p++ = static_cast<char>('0' + empty);
+        *p++ = row < 7 ? '/' : ' ';
+    }
+
+    *p++ = turn_ == PieceColor::White ? 'w' : 'b';
+    *p++ = ' ';
+    if (castling_ & WHITE_OO) *p++ = 'K';
+    if (castling_ & WHITE_OOO) *p++ = 'Q';
+    if (castling_ & BLACK_OO) *p++ = 'k';
+    if (castling_ & BLACK_OOO) *p++ = 'q';
+    if (!castling_) *p++ = '-';
+    *p++ = ' ';
+    if (ep_square_ != NO_SQUARE) {
+        *p++ = static_cast<char>('a' + fileOf(ep_square_));
+        *p++ = static_cast<char>('1' + rankOf(ep_square_));
+    } else {
+        *p++ = '-';
+    }
+
+    char* const limit = buffer + sizeof(buffer) - 1;
+    for (int counter : {halfmove_clock_, fullmoveNumber()}) {
+        *p++ = ' ';
+        auto [ptr, ec] = std::to_chars(p, limit, counter);
+        if (ec != std::errc()) return 0;
+        p = ptr;
+    }
+
+    size_t length = static_cast<size_t>(p - buffer);
+    if (length >= size) return 0;
+    std::memcpy(out, buffer, length);
+    out[length] = '\0';
+    return length;
+}
+
+void Board::makeMove(const Move& move) {
+    using Zobrist::PieceSquare;
+
+    const Square from = move.from();
+    const Square to = move.to();
+    const PieceCode moving = squares_[from];
+    const PieceColor us = turn_;
+
+    UndoInfo& undo = history_.emplace_back();
+    undo.key = key_;
+    undo.pawnKey = pawn_key_;
+    undo.move = move;
+    undo.moved = moving;
+    undo.captured = 0;
+    undo.castling = castling_;
+    undo.epSquare = static_cast<uint8_t>(ep_square_);
+    undo.halfmoveClock = static_cast<uint16_t>(halfmove_clock_);
+
+    uint64_t key = key_ ^ Zobrist::SideToMove;
+    ++halfmove_clock_;
+    if (ep_square_ != NO_SQUARE) {
+        key ^= Zobrist::EnPassantFile[fileOf(ep_square_)];
+        ep_square_ = NO_SQUARE;
+    }
+
+    if (move.isCapture()) {
+        // en-passant: the captured pawn sits beside the mover, on the destination file
+        Square capturedSq = move.isEnpassant() ? to + (us == PieceColor::White ? -8 : 8) : to;
+        PieceCode captured = squares_[capturedSq];
+        undo.captured = captured;
+        removePiece(capturedSq);
+        key ^= PieceSquare[captured][capturedSq];
+        if (typeOf(captured) == PieceType::Pawn) pawn_key_ ^= PieceSquare[captured][capturedSq];
+        halfmove_clock_ = 0;
+    }
+
+    if (move.isCastling()) {
+        Square rookFrom = move.flags() == Move::KingCastle ? to + 1 : to - 2;
+        Square rookTo = move.flags() == Move::KingCastle ? to - 1 : to + 1;
+        key ^= PieceSquare[squares_[rookFrom]][rookFrom] ^ PieceSquare[squares_[rookFrom]][rookTo];
+        movePiece(rookFrom, rookTo);
+    }
+
+    movePiece(from, to);
+    key ^= PieceSquare[moving][from] ^ PieceSquare[moving][to];
+
+    if (typeOf(moving) == PieceType::Pawn) {
+        halfmove_clock_ = 0;
+        pawn_key_ ^= PieceSquare[moving][from];
+        if (move.isPromotion()) {
+            PieceCode promoted = makePieceCode(move.promotionType(), us);
+            removePiece(to);
+            putPiece(to, promoted);
+            key ^= PieceSquare[moving][to] ^ PieceSquare[promoted][to];
+        } else {
+            pawn_key_ ^= PieceSquare[moving][to];
+            // a double push leaves the square it passed over as the en-passant target
+            if (move.flags() == Move::DoublePush) {
+                setEnPassant((from + to) / 2, opposite(us));
+                if (ep_square_ != NO_SQUARE) key ^= Zobrist::EnPassantFile[fileOf(ep_square_)];
             }
         }
+    }
+
+    uint8_t castling = castling_ & CASTLING_MASK[from] & CASTLING_MASK[to];
+    key ^= Zobrist::Castling[castling_] ^ Zobrist::Castling[castling];
+    castling_ = castling;
+
+    key_ = key;
+    turn_ = opposite(us);
+    ++game_ply_;
+}
+
+void Board::unmakeMove() {
+    const UndoInfo& undo = history_.back();
+    const Move move = undo.move;
+    const Square from = move.from();
+    const Square to = move.to();
+
+    turn_ = opposite(turn_);
+    const PieceColor us = turn_;
+
+    if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(to, makePieceCode(PieceType::Pawn, us));
+    }
+
+    movePiece(to, from);
+
+    if (move.isCastling()) {
+        if (move.flags() == Move::KingCastle) movePiece(to - 1, to + 1);
+        else movePiece(to + 1, to - 2);
+    }
+
+    if (undo.captured) {
+        Square capturedSq = move.isEnpassant() ? to + (us == PieceColor::White ? -8 : 8) : to;
+        putPiece(capturedSq, undo.captured);
+    }
+
+    castling_ = undo.castling;
+    ep_square_ = undo.epSquare;
+    halfmove_clock_ = undo.halfmoveClock;
+    key_ = undo.key;
+    pawn_key_ = undo.pawnKey;
+    --game_ply_;
+    history_.pop_back();
+}
+
+bool Board::isRepetition(int times) const {
+    // history_[i].key is the key before move i; same side to move every second entry.
+    int n = static_cast<int>(history_.size());
+    int limit = std::max(0, n - halfmove_clock_);
+    for (int i = n - 2; i >= limit; i -= 2) {
+        if (history_[i].key == key_ && --times == 0) return true;
+    }
+    return false;
+}
+
+bool Board::hasAnyLegalMove() const {
+    return MoveGenerator::hasLegalMove(*this);
+}
+
+bool Board::hasInsufficientMaterial() const {
+    if (pieces(PieceType::Pawn) | pieces(PieceType::Rook) | pieces(PieceType::Queen)) return false;
+    const Bitboard minors = pieces(PieceType::Knight) | pieces(PieceType::Bishop);
+    if (!moreThanOne(minors)) return true;
+    // Same-colored bishops can never cover the squares a mate needs, however many there are.
+    constexpr Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+    return !pieces(PieceType::Knight)
+        && (!(minors & DARK_SQUARES) || !(minors & ~DARK_SQUARES));
+}
+
+void Board::computeKeys() {
+    key_ = 0;
+    pawn_key_ = 0;
+    Bitboard occ = occupied();
+    while (occ) {
+        Square sq = popLsb(occ);
+        key_ ^= Zobrist::PieceSquare[squares_[sq]][sq];
+        if (typeOf(squares_[sq]) == PieceType::Pawn) pawn_key_ ^= Zobrist::PieceSquare[squares_[sq]][sq];
+    }
+    if (turn_ == PieceColor::Black) key_ ^= Zobrist::SideToMove;
+    key_ ^= Zobrist::Castling[castling_];
+    if (ep_square_ != NO_SQUARE) key_ ^= Zobrist::EnPassantFile[fileOf(ep_square_)];
+}
+
+void Board::setEnPassant(Square sq, PieceColor capturer) {
+    // pawns of `capturer` that attack sq are exactly the squares a pawn of the other color attacks from sq
+    if (Bitboards::pawnAttacks(opposite(capturer), sq) & pieces(PieceType::Pawn, capturer))
+        ep_square_ = sq;
+}
+
+bool Board::isPseudoLegal(Move move) const {
+    if (move.isNull()) return false;
+    const PieceColor us = turn_;
+    const Square from = move.from();
+    const Square to = move.to();
+    const PieceCode piece = squares_[from];
+    if (!piece || colorOf(piece) != us || (pieces(us) & squareBB(to))) return false;
+
+    const bool capture = pieces(opposite(us)) & squareBB(to);
+    const unsigned flags = move.flags();
+
+    if (typeOf(piece) == PieceType::Pawn) {
+        const int up = us == PieceColor::White ? 8 : -8;
+        if (move.isEnpassant()) return to == ep_square_ && (Bitboards::pawnAttacks(us, from) & squareBB(to));
+        if (move.isCastling() || move.isCapture() != capture) return false;
+        const bool lastRank = (us == PieceColor::White ? RANK_8_BB : RANK_1_BB) & squareBB(to);
+        if (move.isPromotion() != lastRank) return false;
+        if (capture) return (move.isPromotion() || flags == Move::Capture) && (Bitboards::pawnAttacks(us, from) & squareBB(to));
+        if (flags == Move::DoublePush) {
+            return ((us == PieceColor::White ? RANK_2_BB : RANK_7_BB) & squareBB(from)) && to == from + 2 * up
+                && !(occupied() & (squareBB(from + up) | squareBB(to)));
+        }
+        return to == from + up && !(occupied() & squareBB(to));
+    }
 
-        // throw std::runtime_error("Why is there no king");
-        return false; // no king found?
+    if (move.isCastling()) {
+        if (typeOf(piece) != PieceType::King || from != makeSquare(us == PieceColor::White ? 7 : 0, 4)) return false;
+        const bool kingside = flags == Move::KingCastle;
+        const uint8_t right = us == PieceColor::White ? (kingside ? WHITE_OO : WHITE_OOO) : (kingside ? BLACK_OO : BLACK_OOO);
+        const Square rook = kingside ? from + 3 : from - 4;
+        return (castling_ & right) && to == (kingside ? from + 2 : from - 2)
+            && !(Bitboards::BetweenBB[from][rook] & occupied());
     }
+
+    if (flags != (capture ? Move::Capture : Move::Quiet)) return false;
+    switch (typeOf(piece)) {
+    case PieceType::Knight: return Bitboards::KnightAttacks[from] & squareBB(to);
+    case PieceType::Bishop: return Bitboards::bishopAttacks(from, occupied()) & squareBB(to);
+    case PieceType::Rook:   return Bitboards::rookAttacks(from, occupied()) & squareBB(to);
+    case PieceType::Queen:  return Bitboards::queenAttacks(from, occupied()) & squareBB(to);
+    case PieceType::King:   return Bitboards::KingAttacks[from] & squareBB(to);
+    default: return false;
+    }
+}
+
+bool Board::isLegal(Move move) const {
+    const PieceColor us = turn_;
+    const PieceColor them = opposite(us);
+    const Square from = move.from();
+    const Square to = move.to();
+    const Square king = kingSquare(us);
+    if (king == NO_SQUARE) return false;
+
+    if (move.isEnpassant()) {
+        // Two pawns leave their squares at once; test the resulting occupancy directly.
+        Square captured = to + (us == PieceColor::White ? -8 : 8);
+        Bitboard occ = (occupied() ^ squareBB(from) ^ squareBB(captured)) | squareBB(to);
+        return !(attackersTo(king, occ) & pieces(them) & ~squareBB(captured));
+    }
+
+    if (from == king) {
+        if (move.isCastling()) {
+            Square step = to > from ? 1 : -1;
+            for (Square sq = from; sq != to + step; sq += step)
+                if (isSquareAttacked(sq, them)) return false;
+            return true;
+        }
+        return !(attackersTo(to, occupied() ^ squareBB(from)) & pieces(them));
+    }
+
+    Bitboard checking = attackersTo(king, them);
+    if (checking) {
+        if (moreThanOne(checking)) return false;
+        if (!((Bitboards::BetweenBB[king][lsb(checking)] | checking) & squareBB(to))) return false;
+    }
+    return !(blockersForKing(us) & squareBB(from)) || Bitboards::aligned(king, from, to);
+}
+
+void Board::legalMoves(MoveList& out) const {
+    MoveGenerator::generateAll(*this, out);
+}
+
+std::vector<Move> Board::legalMoves() const {
+    MoveList list;
+    MoveGenerator::generateAll(*this, list);
+    return std::vector<Move>(list.begin(), list.end());
+}
+
+std::vector<Move> Board::legalMovesFrom(const Position& p) const {
+    MoveList list;
+    MoveGenerator::generateFrom(*this, p, list);
+    return std::vector<Move>(list.begin(), list.end());
+}
+
+Bitboard Board::blockersForKing(PieceColor c) const {
+    Square king = kingSquare(c);
+    if (king == NO_SQUARE) return 0;
+    PieceColor them = opposite(c);
+
+    // enemy sliders that would hit the king on an empty board
+    Bitboard snipers = ((Bitboards::rookAttacks(king, 0) & (pieces(PieceType::Rook) | pieces(PieceType::Queen)))
+                      | (Bitboards::bishopAttacks(king, 0) & (pieces(PieceType::Bishop) | pieces(PieceType::Queen))))
+                      & pieces(them);
+    Bitboard blockers = 0;
+    while (snipers) {
+        Bitboard between = Bitboards::BetweenBB[king][popLsb(snipers)] & occupied();
+        if (between && !moreThanOne(between)) blockers |= between;
+    }
+    return blockers;
+}
@@ -0,0 +1,82 @@
+#include "Epd.h"
+
+#include <charconv>
+
+namespace {
+
+bool isBlank(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && isBlank(text.front())) text.remove_prefix(1);
+    while (!text.empty() && isBlank(text.back())) text.remove_suffix(1);
+    return text;
+}
+
+// Split the operations after the position into `entry`. Opcodes run up to the first blank or
+// ';', operands up to the next ';' outside double quotes.
+void parseOperations(std::string_view text, EpdEntry& entry) {
+    size_t pos = 0;
+    while (pos < text.size() && entry.operationCount < EpdEntry::MAX_OPERATIONS) {
+        while (pos < text.size() && (isBlank(text[pos]) || text[pos] == ';')) pos++;
+        if (pos == text.size()) break;
+
+        size_t start = pos;
+        while (pos < text.size() && !isBlank(text[pos]) && text[pos] != ';') pos++;
+        std::string_view opcode = text.substr(start, pos - start);
+
+        start = pos;
+        bool quoted = false;
+        while (pos < text.size() && (quoted || text[pos] != ';')) {
+            if (text[pos] == '"') quoted = !quoted;
+            pos++;
+        }
+        entry.operations[entry.operationCount++] = {opcode, trim(text.substr(start, pos - start))};
+    }
+}
+
+} // namespace
+
+const EpdOperation* EpdEntry::find(std::string_view opcode) const {
+    for (int i = 0; i < operationCount; i++)
+        if (operations[i].opcode == opcode) return &operations[i];
+    return nullptr;
+}
+
+bool EpdEntry::integer(std::string_view opcode, uint64_t& value) const {
+    const EpdOperation* op = find(opcode);
+    if (!op) return false;
+    const char* end = op->operands.data() + op->operands.size();
+    auto [ptr, ec] = std::from_chars(op->operands.data(), end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+bool EpdReader::open(const std::string& path, std::string& error) {
+    if (!file_.open(path, error)) return false;
+    file_.adviseSequential();
+    text_ = file_.view();
+    pos_ = 0;
+    lineNumber_ = 0;
+    return true;
+}
+
+bool EpdReader::next(EpdEntry& entry) {
+    while (pos_ < text_.size()) {
+        size_t newline = text_.find('\n', pos_);
+        if (newline == std::string_view::npos) newline = text_.size();
+        std::string_view line = trim(text_.substr(pos_, newline - pos_));
+        pos_ = newline + (newline < text_.size());
+        lineNumber_++;
+        if (line.empty() || line.front() == '#') continue;
+
+        entry.line = line;
+        entry.lineNumber = lineNumber_;
+        entry.error = FenError{};
+        entry.operationCount = 0;
+        size_t end = 0;
+        if (entry.board.setFEN(line, &entry.error, &end)) parseOperations(line.substr(end), entry);
+        return true;
+    }
+    return false;
+}
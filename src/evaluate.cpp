@@ -0,0 +1,33 @@
+#include "Evaluate.h"
+
+#include <algorithm>
+
+#ifdef CHESS_CHECK_EVAL
+#include <cstdio>
+#include <cstdlib>
+#endif
+
+int evaluate(const Board& board) {
+#ifdef CHESS_CHECK_EVAL
+    if (!verifyEvalTerms(board)) {
+        std::fprintf(stderr, "incremental evaluation terms out of sync:\n%s\n", board.toString().c_str());
+        std::abort();
+    }
+#endif
+    const Score psq = board.psqScore();
+    const int phase = std::min(board.gamePhase(), Psqt::MAX_PHASE);
+    const int score = (mgValue(psq) * phase + egValue(psq) * (Psqt::MAX_PHASE - phase)) / Psqt::MAX_PHASE;
+    return board.getTurn() == PieceColor::White ? score : -score;
+}
+
+bool verifyEvalTerms(const Board& board) {
+    Score psq = 0;
+    int phase = 0;
+    for (Bitboard b = board.occupied(); b;) {
+        Square sq = popLsb(b);
+        PieceCode code = board.pieceOn(sq);
+        psq += Psqt::Table[code][sq];
+        phase += Psqt::PHASE_WEIGHT[code & 7];
+    }
+    return psq == board.psqScore() && phase == board.gamePhase();
+}
@@ -1,8 +1,14 @@
 #include <iostream>
 #include "board.h"
+#include "Analyzer.h"
 
 #include <SFML/Graphics.hpp>
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
 #include <string>
 
 const int TILE_SIZE = 80;
@@ -19,6 +25,75 @@ std::string getPieceAsset(PieceType type, PieceColor color) {
     return "undefined piece";
 }
 
+// All twelve piece images in one texture, one row per color and one column per type, so every
+// piece on the board is drawn with a single draw call.
+struct PieceAtlas {
+    sf::Texture texture;
+    sf::Vector2f cell;
+
+    void load() {
+        sf::Image images[2][6];
+        sf::Vector2u size;
+        for (int c = 0; c < 2; c++) {
+            for (int t = 0; t < 6; t++) {
+                std::string path = getPieceAsset(static_cast<PieceType>(t + 1), c == 0 ? PieceColor::White : PieceColor::Black);
+                if (!images[c][t].loadFromFile(path)) throw std::runtime_error("Could not find file " + path);
+                size.x = std::max(size.x, images[c][t].getSize().x);
+                size.y = std::max(size.y, images[c][t].getSize().y);
+            }
+        }
+
+        sf::Image atlas({size.x * 6, size.y * 2}, sf::Color::Transparent);
+        for (int c = 0; c < 2; c++)
+            for (int t = 0; t < 6; t++)
+                if (!atlas.copy(images[c][t], {size.x * t, size.y * c})) throw std::runtime_error("Could not build the piece atlas");
+        if (!texture.loadFromImage(atlas)) throw std::runtime_error("Could not create the piece atlas");
+        // The images are larger than a square; filter them when scaling down.
+        texture.setSmooth(true);
+        cell = sf::Vector2f(size);
+    }
+
+    // Top-left texture coordinate of a piece's image.
+    sf::Vector2f origin(PieceCode code) const {
+        int column = static_cast<int>(typeOf(code)) - 1;
+        int row = colorOf(code) == PieceColor::White ? 0 : 1;
+        return {cell.x * column, cell.y * row};
+    }
+};
+
+// Two triangles covering a rectangle, optionally textured with the same-shaped texture area.
+void appendQuad(sf::VertexArray& vertices, sf::Vector2f pos, sf::Vector2f size, sf::Color color,
+                sf::Vector2f texPos = {}, sf::Vector2f texSize = {}) {
+    const sf::Vector2f corners[4] = {pos, {pos.x + size.x, pos.y}, {pos.x + size.x, pos.y + size.y}, {pos.x, pos.y + size.y}};
+    const sf::Vector2f tex[4] = {texPos, {texPos.x + texSize.x, texPos.y}, {texPos.x + texSize.x, texPos.y + texSize.y}, {texPos.x, texPos.y + texSize.y}};
+    for (int i : {0, 1, 2, 0, 2, 3}) vertices.append(sf::Vertex{corners[i], color, tex[i]});
+}
+
+// A filled circle as a fan of triangles.
+void appendDisc(sf::VertexArray& vertices, sf::Vector2f center, float radius, sf::Color color) {
+    constexpr int SEGMENTS = 20;
+    constexpr float TAU = 6.28318531f;
+    for (int i = 0; i < SEGMENTS; i++) {
+        float a0 = TAU * i / SEGMENTS;
+        float a1 = TAU * (i + 1) / SEGMENTS;
+        vertices.append(sf::Vertex{center, color, {}});
+        vertices.append(sf::Vertex{{center.x + radius * std::cos(a0), center.y + radius * std::sin(a0)}, color, {}});
+        vertices.append(sf::Vertex{{center.x + radius * std::cos(a1), center.y + radius * std::sin(a1)}, color, {}});
+    }
+}
+
+// Window title with the latest analysis, score from white's point of view.
+std::string analysisTitle(const AnalysisUpdate& u, PieceColor turn) {
+    int score = turn == PieceColor::White ? u.score : -u.score;
+    char eval[32];
+    if (std::abs(score) >= VALUE_MATE_IN_MAX_PLY)
+        std::snprintf(eval, sizeof(eval), "#%d", score > 0 ? (VALUE_MATE - score + 1) / 2 : -(VALUE_MATE + score) / 2);
+    else std::snprintf(eval, sizeof(eval), "%+.2f", score / 100.0);
+    std::string title = "Chess Game - depth " + std::to_string(u.depth) + " " + eval + " ";
+    for (int i = 0; i < u.pvLength; i++) title += " " + toUci(u.pv[i]);
+    return title;
+}
+
 int main()
 {
     Position draggingPieceFrom(-1, -1);
@@ -26,141 +101,156 @@ int main()
     sf::Vector2i mousePosition;
 
     sf::RenderWindow window(sf::VideoMode({TILE_SIZE * BOARD_SIZE, TILE_SIZE * BOARD_SIZE}), "Chess Game");
-    window.setFramerateLimit(15);
+    // Frames are only drawn when something changed; vsync paces them while dragging.
+    window.setVerticalSyncEnabled(true);
     Board board;
 
-    // Load piece textures
-    std::unordered_map<std::string, sf::Texture> textures;
-    for (auto color : {PieceColor::White, PieceColor::Black}) {
-        for (auto type : {PieceType::Pawn, PieceType::Knight, PieceType::Bishop, PieceType::Rook, PieceType::Queen, PieceType::King}) {
-            std::string path = getPieceAsset(type, color);
-            if (!path.empty()) {
-                textures[path] = sf::Texture(path);
-                if (!textures[path].loadFromFile(path)) throw std::runtime_error("Could not find file!");
-            }
+    PieceAtlas atlas;
+    atlas.load();
+    sf::VertexArray boardVertices(sf::PrimitiveType::Triangles);
+    sf::VertexArray pieceVertices(sf::PrimitiveType::Triangles);
+
+    // Legal moves of the current position, generated once per position change; the indicators
+    // and move input are both served from here.
+    MoveList legalMoves;
+    board.legalMoves(legalMoves);
+
+    // Press A to toggle analysis. It runs on its own threads and reports through a queue that
+    // is drained between events, so the event loop never waits for the engine.
+    Analyzer analyzer(64, static_cast<int>(std::max(1u, std::thread::hardware_concurrency() / 2)));
+    bool analyzing = false;
+
+    auto positionChanged = [&]() {
+        legalMoves.clear();
+        board.legalMoves(legalMoves);
+        if (analyzing) analyzer.analyze(board);
+        else window.setTitle("Chess Game");
+    };
+
+    // Returns whether the event changes what is on screen.
+    auto handleEvent = [&](const sf::Event& event) {
+        if (event.is<sf::Event::Closed>()) {
+            window.close();
+            return false;
         }
-    }
 
-    while (window.isOpen())
-    {
-        while (const std::optional event = window.pollEvent())
-        {
-            if (event->is<sf::Event::Closed>())
-                window.close();
-
-            if (auto* mousePressed = event->getIf<sf::Event::MouseButtonPressed>()) {
-                if (mousePressed->button == sf::Mouse::Button::Left) {
-                    mousePosition = mousePressed->position;
-                    sf::Vector2f worldPos = window.mapPixelToCoords(mousePosition);
-                    Position boardPos(worldPos.y / TILE_SIZE, worldPos.x / TILE_SIZE);
-                    if (board.inBounds(boardPos)) {
-                        const Piece* piece = board.getPiece(boardPos);
-                        if (piece && piece->color() == board.getTurn()) {
-                            draggingPieceFrom = boardPos;
-                            draggingMoves = board.legalMovesFrom(draggingPieceFrom);
-                        }
+        if (event.is<sf::Event::Resized>() || event.is<sf::Event::FocusGained>()) return true;
+
+        if (auto* mousePressed = event.getIf<sf::Event::MouseButtonPressed>()) {
+            if (mousePressed->button == sf::Mouse::Button::Left) {
+                mousePosition = mousePressed->position;
+                sf::Vector2f worldPos = window.mapPixelToCoords(mousePosition);
+                Position boardPos(worldPos.y / TILE_SIZE, worldPos.x / TILE_SIZE);
+                if (board.inBounds(boardPos)) {
+                    const Piece* piece = board.getPiece(boardPos);
+                    if (piece && piece->color() == board.getTurn()) {
+                        draggingPieceFrom = boardPos;
+                        draggingMoves.clear();
+                        for (Move m : legalMoves)
+                            if (m.from() == toSquare(boardPos)) draggingMoves.push_back(m);
+                        return true;
                     }
                 }
             }
+            return false;
+        }
 
-            if (auto* mouseReleased = event->getIf<sf::Event::MouseButtonReleased>()) {
-                if (mouseReleased->button == sf::Mouse::Button::Left) {
-                    mousePosition = mouseReleased->position;
-                    sf::Vector2f worldPos = window.mapPixelToCoords(mousePosition);
-                    Position boardPos(worldPos.y / TILE_SIZE, worldPos.x / TILE_SIZE);
-                    if (board.inBounds(boardPos)) {
-                        // should handle this a better way
-                        Move m;
-                        m.from = draggingPieceFrom;
-                        m.to = boardPos;
-                        board.tryMakeMove(m);
-                        draggingPieceFrom = {-1, -1};
-                    }
+        if (auto* mouseReleased = event.getIf<sf::Event::MouseButtonReleased>()) {
+            if (mouseReleased->button != sf::Mouse::Button::Left || !board.inBounds(draggingPieceFrom)) return false;
+            mousePosition = mouseReleased->position;
+            sf::Vector2f worldPos = window.mapPixelToCoords(mousePosition);
+            Position boardPos(worldPos.y / TILE_SIZE, worldPos.x / TILE_SIZE);
+            if (board.inBounds(boardPos)) {
+                // Promotions come queen first from the generator, so the first match auto-queens.
+                auto it = std::find_if(draggingMoves.begin(), draggingMoves.end(),
+                                       [&](Move m) { return m.to() == toSquare(boardPos); });
+                if (it != draggingMoves.end()) {
+                    board.makeMove(*it);
+                    positionChanged();
                 }
             }
+            draggingPieceFrom = {-1, -1};
+            draggingMoves.clear();
+            return true;
+        }
 
-            if (auto* mouseMoved = event->getIf<sf::Event::MouseMoved>()) {
-                mousePosition = mouseMoved->position;
+        if (auto* mouseMoved = event.getIf<sf::Event::MouseMoved>()) {
+            mousePosition = mouseMoved->position;
+            return board.inBounds(draggingPieceFrom);
+        }
+
+        if (auto* keyPressed = event.getIf<sf::Event::KeyPressed>()) {
+            if (keyPressed->code == sf::Keyboard::Key::A) {
+                analyzing = !analyzing;
+                if (analyzing) analyzer.analyze(board);
+                else analyzer.pause();
+                window.setTitle("Chess Game");
             }
         }
+        return false;
+    };
 
-        window.clear();
-        // Draw chessboard
+    auto rebuildBatches = [&]() {
+        const sf::Vector2f tile(TILE_SIZE, TILE_SIZE);
+        boardVertices.clear();
+        pieceVertices.clear();
 
         for (int r = 0; r < BOARD_SIZE; r++) {
             for (int c = 0; c < BOARD_SIZE; c++) {
-                sf::RectangleShape square(sf::Vector2f(TILE_SIZE, TILE_SIZE));
-                square.setPosition({
-                    static_cast<float>(c * TILE_SIZE),
-                    static_cast<float>(r * TILE_SIZE)
-                });
                 bool light = (r + c) % 2 == 0;
-                square.setFillColor(light ? sf::Color(240, 217, 181) : sf::Color(181, 136, 99));
-                window.draw(square);
+                appendQuad(boardVertices, {c * tile.x, r * tile.y}, tile,
+                           light ? sf::Color(240, 217, 181) : sf::Color(181, 136, 99));
 
-                // Draw piece if present
+                // The dragged piece is drawn last, on top, under the cursor.
                 Position pos(r, c);
                 const Piece* piece = board.getPiece(pos);
-                if (piece) {
-                    std::string asset = getPieceAsset(piece->type(), piece->color());
-                    if (!asset.empty() && textures.count(asset)) {
-                        sf::Sprite sprite(textures[asset]);
-
-                        if (r == draggingPieceFrom.row && c == draggingPieceFrom.col) {
-                            continue; // draw it at the end
-                        }
-
-                        sprite.setPosition({
-                            static_cast<float>(c * TILE_SIZE),
-                            static_cast<float>(r * TILE_SIZE)
-                        });
-
-                        sprite.setScale({
-                            TILE_SIZE / static_cast<float>(textures[asset].getSize().x),
-                            TILE_SIZE / static_cast<float>(textures[asset].getSize().y)
-                        });
-
-                        window.draw(sprite);
-                    }
+                if (piece && !(r == draggingPieceFrom.row && c == draggingPieceFrom.col)) {
+                    PieceCode code = makePieceCode(piece->type(), piece->color());
+                    appendQuad(pieceVertices, {c * tile.x, r * tile.y}, tile, sf::Color::White, atlas.origin(code), atlas.cell);
                 }
             }
         }
 
-        if (draggingPieceFrom.row != -1 && draggingPieceFrom.col != -1) {
-
-            sf::CircleShape indicator;
-            static sf::Color indicatorColor(45, 45, 45, 45);
-            indicator.setFillColor(indicatorColor);
-            indicator.setRadius(15);
-            indicator.setOrigin({15, 15});
+        if (board.inBounds(draggingPieceFrom)) {
             for (const auto& m : draggingMoves) {
-                indicator.setPosition({
-                    static_cast<float>(m.to.col * TILE_SIZE + TILE_SIZE / 2),
-                    static_cast<float>(m.to.row * TILE_SIZE + TILE_SIZE / 2)
-                });
-                window.draw(indicator);
+                Position to = toPosition(m.to());
+                appendDisc(boardVertices, {to.col * tile.x + tile.x / 2, to.row * tile.y + tile.y / 2}, 15,
+                           sf::Color(45, 45, 45, 45));
             }
 
             const Piece* piece = board.getPiece(draggingPieceFrom);
             if (piece) {
-                std::string asset = getPieceAsset(piece->type(), piece->color());
-                if (!asset.empty() && textures.count(asset)) {
-                    sf::Sprite sprite(textures[asset]);
+                sf::Vector2f worldPos = window.mapPixelToCoords(mousePosition);
+                PieceCode code = makePieceCode(piece->type(), piece->color());
+                appendQuad(pieceVertices, {worldPos.x - tile.x / 2, worldPos.y - tile.y / 2}, tile, sf::Color::White,
+                           atlas.origin(code), atlas.cell);
+            }
+        }
+    };
 
-                    sf::Vector2f worldPos = window.mapPixelToCoords(mousePosition);
-                    sprite.setPosition(worldPos);
+    bool dirty = true;
+    while (window.isOpen())
+    {
+        // Sleep until there is input; while analysing, also wake up regularly for its reports.
+        std::optional<sf::Event> event = window.waitEvent(analyzing ? sf::milliseconds(100) : sf::Time::Zero);
+        while (event) {
+            dirty |= handleEvent(*event);
+            event = window.pollEvent();
+        }
+        if (!window.isOpen()) break;
 
-                    sprite.setScale({
-                        TILE_SIZE / static_cast<float>(textures[asset].getSize().x),
-                        TILE_SIZE / static_cast<float>(textures[asset].getSize().y)
-                    });
+        AnalysisUpdate update;
+        while (analyzer.poll(update)) {
+            if (analyzing && update.key == board.key()) window.setTitle(analysisTitle(update, board.getTurn()));
+        }
 
-                    sprite.setOrigin({TILE_SIZE, TILE_SIZE});
+        if (!dirty) continue;
+        dirty = false;
 
-                    window.draw(sprite);
-                }
-            }
-        }
+        rebuildBatches();
+        window.clear();
+        window.draw(boardVertices);
+        window.draw(pieceVertices, sf::RenderStates(&atlas.texture));
         window.display();
     }
 }
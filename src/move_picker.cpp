@@ -0,0 +1,181 @@
+#include "MovePicker.h"
+#include "Evaluate.h"
+#include "MoveGenerator.h"
+
+#include <utility>
+
+namespace {
+
+// The move classes of GenType::Captures: captures other than underpromotions, and queen
+// promotions.
+bool isCaptureClass(Move m) {
+    return m.isPromotion() ? m.promotionType() == PieceType::Queen : m.isCapture();
+}
+
+} // namespace
+
+bool seeGe(const Board& board, Move move, int threshold) {
+    if (move.isCastling() || move.isEnpassant() || move.isPromotion()) return threshold <= 0;
+
+    const Square from = move.from();
+    const Square to = move.to();
+
+    // `swap` is what the side to move stands to gain if the exchange stops here, minus the
+    // threshold; `result` flips with every capture and is the outcome once a side stops.
+    int swap = PIECE_VALUES[static_cast<int>(typeOf(board.pieceOn(to)))] - threshold;
+    if (swap < 0) return false;
+    swap = PIECE_VALUES[static_cast<int>(typeOf(board.pieceOn(from)))] - swap;
+    if (swap <= 0) return true;
+
+    const Bitboard bishops = board.pieces(PieceType::Bishop) | board.pieces(PieceType::Queen);
+    const Bitboard rooks = board.pieces(PieceType::Rook) | board.pieces(PieceType::Queen);
+    Bitboard occupied = board.occupied() ^ squareBB(from) ^ squareBB(to);
+    Bitboard attackers = board.attackersTo(to, occupied);
+    PieceColor side = board.getTurn();
+    bool result = true;
+
+    while (true) {
+        side = opposite(side);
+        attackers &= occupied;
+        const Bitboard ours = attackers & board.pieces(side);
+        if (!ours) break;
+        result = !result;
+
+        // Capture with the least valuable attacker; removing it may uncover a slider behind.
+        PieceType type = PieceType::Pawn;
+        while (!(ours & board.pieces(type))) type = static_cast<PieceType>(static_cast<int>(type) + 1);
+        if (type == PieceType::King) {
+            // The king may only take last: if the other side still attacks, it cannot.
+            return (attackers & ~board.pieces(side)) ? !result : result;
+        }
+        swap = PIECE_VALUES[static_cast<int>(type)] - swap;
+        if (swap < static_cast<int>(result)) break;
+        occupied ^= squareBB(lsb(ours & board.pieces(type)));
+        if (type == PieceType::Pawn || type == PieceType::Bishop || type == PieceType::Queen)
+            attackers |= Bitboards::bishopAttacks(to, occupied) & bishops;
+        if (type == PieceType::Rook || type == PieceType::Queen)
+            attackers |= Bitboards::rookAttacks(to, occupied) & rooks;
+    }
+    return result;
+}
+
+MovePicker::MovePicker(const Board& board, Move ttMove, const Move* killers, const int (*history)[64])
+: board_(board)
+, stage_(Stage::TTMove)
+, ttMove_(ttMove)
+, history_(history)
+{
+    killers_[0] = killers[0];
+    killers_[1] = killers[1];
+}
+
+MovePicker::MovePicker(const Board& board, Move ttMove)
+: board_(board)
+, stage_(board.checkers() ? Stage::TTMove : Stage::QTTMove)
+, ttMove_(ttMove)
+{
+}
+
+Move MovePicker::pickBest(MoveList& moves, int* scores, size_t cur) {
+    size_t best = cur;
+    for (size_t i = cur + 1; i < moves.size(); i++)
+        if (scores[i] > scores[best]) best = i;
+    std::swap(moves[cur], moves[best]);
+    std::swap(scores[cur], scores[best]);
+    return moves[cur];
+}
+
+void MovePicker::scoreCaptures() {
+    for (size_t i = 0; i < captures_.size(); i++) {
+        const Move m = captures_[i];
+        // Most valuable victim first, least valuable attacker breaking ties.
+        int victim = m.isEnpassant() ? PAWN_VALUE : PIECE_VALUES[static_cast<int>(typeOf(board_.pieceOn(m.to())))];
+        int attacker = static_cast<int>(typeOf(board_.pieceOn(m.from())));
+        captureScores_[i] = victim * 8 - attacker + PIECE_VALUES[static_cast<int>(m.promotionType())];
+    }
+}
+
+void MovePicker::scoreQuiets() {
+    for (size_t i = 0; i < quiets_.size(); i++)
+        quietScores_[i] = history_ ? history_[quiets_[i].from()][quiets_[i].to()] : 0;
+}
+
+Move MovePicker::next() {
+    switch (stage_) {
+    case Stage::TTMove:
+        stage_ = Stage::GenerateCaptures;
+        if (usable(ttMove_)) return ttMove_;
+        [[fallthrough]];
+
+    case Stage::GenerateCaptures:
+        MoveGenerator::generateCaptures(board_, captures_);
+        scoreCaptures();
+        stage_ = Stage::GoodCaptures;
+        [[fallthrough]];
+
+    case Stage::GoodCaptures:
+        while (captureIndex_ < captures_.size()) {
+            Move m = pickBest(captures_, captureScores_, captureIndex_++);
+            if (m == ttMove_) continue;
+            if (!seeGe(board_, m, 0)) {
+                captures_[badCount_++] = m;
+                continue;
+            }
+            return m;
+        }
+        stage_ = Stage::Killers;
+        [[fallthrough]];
+
+    case Stage::Killers:
+        while (killerIndex_ < 2) {
+            Move& m = killers_[killerIndex_++];
+            if (m != ttMove_ && !isCaptureClass(m) && !(killerIndex_ == 2 && m == killers_[0]) && usable(m)) return m;
+            // Not played here, so not to be skipped among the quiet moves either.
+            m = Move{};
+        }
+        stage_ = Stage::GenerateQuiets;
+        [[fallthrough]];
+
+    case Stage::GenerateQuiets:
+        MoveGenerator::generateQuiets(board_, quiets_);
+        scoreQuiets();
+        stage_ = Stage::Quiets;
+        [[fallthrough]];
+
+    case Stage::Quiets:
+        while (quietIndex_ < quiets_.size()) {
+            Move m = pickBest(quiets_, quietScores_, quietIndex_++);
+            if (m != ttMove_ && m != killers_[0] && m != killers_[1]) return m;
+        }
+        stage_ = Stage::BadCaptures;
+        [[fallthrough]];
+
+    case Stage::BadCaptures:
+        if (badIndex_ < badCount_) return captures_[badIndex_++];
+        stage_ = Stage::Done;
+        return Move{};
+
+    case Stage::QTTMove:
+        stage_ = Stage::QGenerateCaptures;
+        if (isCaptureClass(ttMove_) && usable(ttMove_)) return ttMove_;
+        [[fallthrough]];
+
+    case Stage::QGenerateCaptures:
+        MoveGenerator::generateCaptures(board_, captures_);
+        scoreCaptures();
+        stage_ = Stage::QCaptures;
+        [[fallthrough]];
+
+    case Stage::QCaptures:
+        while (captureIndex_ < captures_.size()) {
+            Move m = pickBest(captures_, captureScores_, captureIndex_++);
+            if (m != ttMove_) return m;
+        }
+        stage_ = Stage::Done;
+        [[fallthrough]];
+
+    case Stage::Done:
+        break;
+    }
+    return Move{};
+}
@@ -0,0 +1,227 @@
+#include "Nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Nnue {
+
+namespace {
+
+constexpr char MAGIC[4] = {'C', 'N', 'N', 'U'};
+constexpr uint32_t VERSION = 1;
+
+template <typename T>
+bool readArray(std::istream& in, std::vector<T>& out, size_t count) {
+    out.resize(count);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(out.data()), count * sizeof(T)));
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+// Squares of the rook before and after castling with the king landing on `kingTo`.
+void castlingRookSquares(Move move, Square& rookFrom, Square& rookTo) {
+    const Square kingTo = move.to();
+    rookFrom = move.flags() == Move::KingCastle ? kingTo + 1 : kingTo - 2;
+    rookTo = move.flags() == Move::KingCastle ? kingTo - 1 : kingTo + 1;
+}
+
+} // namespace
+
+int featureIndex(PieceColor perspective, Square ksq, PieceCode code, Square sq) {
+    // See the board from the perspective's own side, and keep its king on files a-d.
+    const int flip = (perspective == PieceColor::Black ? 56 : 0) ^ (fileOf(ksq) >= 4 ? 7 : 0);
+    const int relative = colorOf(code) == perspective ? 0 : 1;
+    return (relative * 6 + (code & 7) - 1) * 64 + (sq ^ flip);
+}
+
+Network::Network()
+: ftBias_(HIDDEN, 0)
+, ftWeights_(static_cast<size_t>(INPUTS) * HIDDEN, 0)
+, l1Bias_(L1_OUTPUTS, 0)
+, l1Weights_(static_cast<size_t>(L1_OUTPUTS) * L1_INPUTS, 0)
+, l2Weights_(L1_OUTPUTS, 0)
+{
+    setIsa(bestIsa());
+}
+
+void Network::setIsa(Isa isa) {
+    isa_ = isa;
+    kernels_ = &kernels(isa);
+}
+
+bool Network::load(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0, hidden = 0;
+    if (!in.read(magic, 4) || !readValue(in, version) || !readValue(in, hidden)) {
+        error = path + ": truncated header";
+        return false;
+    }
+    if (std::memcmp(magic, MAGIC, 4) != 0 || version != VERSION || hidden != HIDDEN) {
+        error = path + ": not a version 1 network with " + std::to_string(HIDDEN) + " hidden units";
+        return false;
+    }
+
+    std::vector<int16_t> ftBias, ftWeights;
+    std::vector<int32_t> l1Bias;
+    std::vector<int8_t> l1Weights, l2Weights;
+    int32_t l2Bias = 0;
+    bool ok = readArray(in, ftBias, HIDDEN)
+           && readArray(in, ftWeights, static_cast<size_t>(INPUTS) * HIDDEN)
+           && readArray(in, l1Bias, L1_OUTPUTS)
+           && readArray(in, l1Weights, static_cast<size_t>(L1_OUTPUTS) * L1_INPUTS)
+           && readValue(in, l2Bias)
+           && readArray(in, l2Weights, L1_OUTPUTS);
+    if (!ok) {
+        error = path + ": truncated weights";
+        return false;
+    }
+    if (in.peek() != std::char_traits<char>::eof()) {
+        error = path + ": trailing data after the weights";
+        return false;
+    }
+
+    ftBias_ = std::move(ftBias);
+    ftWeights_ = std::move(ftWeights);
+    l1Bias_ = std::move(l1Bias);
+    l1Weights_ = std::move(l1Weights);
+    l2Bias_ = l2Bias;
+    l2Weights_ = std::move(l2Weights);
+    return true;
+}
+
+void Network::randomize(uint64_t seed) {
+    // splitmix64, as in Zobrist.
+    auto next = [&seed](int range) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return static_cast<int>(z % (2 * range + 1)) - range;
+    };
+    // Ranges keep every sum well inside int16 for the accumulator and away from saturation.
+    for (auto& w : ftBias_) w = static_cast<int16_t>(next(32) + 32);
+    for (auto& w : ftWeights_) w = static_cast<int16_t>(next(24));
+    for (auto& w : l1Bias_) w = next(1024);
+    for (auto& w : l1Weights_) w = static_cast<int8_t>(next(16));
+    l2Bias_ = 0;
+    for (auto& w : l2Weights_) w = static_cast<int8_t>(next(64));
+}
+
+void Network::refresh(const Board& board, PieceColor perspective, int16_t* out) const {
+    // One column per piece; sized for a full board so no position can overrun it.
+    const int16_t* columns[64];
+    int count = 0;
+    const Square ksq = board.kingSquare(perspective);
+    for (Bitboard b = board.occupied(); b;) {
+        Square sq = popLsb(b);
+        columns[count++] = column(featureIndex(perspective, ksq, board.pieceOn(sq), sq));
+    }
+    kernels_->update(out, ftBias_.data(), columns, count, nullptr, 0);
+}
+
+int Network::propagate(const int16_t* us, const int16_t* them) const {
+    alignas(64) uint8_t input[L1_INPUTS];
+    alignas(64) int32_t hidden[L1_OUTPUTS];
+    kernels_->transform(us, them, input);
+    kernels_->affine(input, l1Weights_.data(), l1Bias_.data(), hidden);
+
+    int32_t output = l2Bias_;
+    for (int j = 0; j < L1_OUTPUTS; j++) output += std::clamp(hidden[j] >> L1_SHIFT, 0, 127) * l2Weights_[j];
+    return output / OUTPUT_DIVISOR;
+}
+
+int Network::evaluate(const Board& board) const {
+    alignas(64) int16_t acc[2][HIDDEN];
+    refresh(board, PieceColor::White, acc[0]);
+    refresh(board, PieceColor::Black, acc[1]);
+    const int us = board.getTurn() == PieceColor::White ? 0 : 1;
+    return propagate(acc[us], acc[us ^ 1]);
+}
+
+void Evaluator::setNetwork(const Network* network) {
+    if (network == network_) return;
+    network_ = network;
+    stack_.clear();
+}
+
+int Evaluator::evaluate(const Board& board) {
+    const int ply = static_cast<int>(board.history().size());
+    if (static_cast<int>(stack_.size()) <= ply) stack_.resize(ply + 1);
+    update(board, ply, 0);
+    update(board, ply, 1);
+
+    const Accumulator& acc = stack_[ply];
+    const int us = board.getTurn() == PieceColor::White ? 0 : 1;
+    return network_->propagate(acc.values[us], acc.values[us ^ 1]);
+}
+
+void Evaluator::update(const Board& board, int ply, int perspective) {
+    const std::vector<UndoInfo>& history = board.history();
+    const PieceColor color = perspective == 0 ? PieceColor::White : PieceColor::Black;
+    const PieceCode ourKing = makePieceCode(PieceType::King, color);
+    auto keyAt = [&](int p) { return p < ply ? history[p].key : board.key(); };
+
+    // Claim stack_[p] for the position at ply p, dropping values left from another line.
+    auto claim = [&](int p) -> int16_t* {
+        Accumulator& acc = stack_[p];
+        const uint64_t key = keyAt(p);
+        if (acc.key != key) {
+            acc.key = key;
+            acc.computed[0] = acc.computed[1] = false;
+        }
+        acc.computed[perspective] = true;
+        return acc.values[perspective];
+    };
+
+    // Nearest ply with usable values that only piece deltas separate from this one.
+    int start = ply;
+    while (!(stack_[start].key == keyAt(start) && stack_[start].computed[perspective])) {
+        const UndoInfo* undo = start > 0 ? &history[start - 1] : nullptr;
+        if (!undo || (undo->moved == ourKing && (fileOf(undo->move.from()) >= 4) != (fileOf(undo->move.to()) >= 4))) {
+            network_->refresh(board, color, claim(ply));
+            return;
+        }
+        start--;
+    }
+
+    // The king stays on one side of the board from `start` on, so the current king square gives
+    // the mirroring for every step.
+    const Square ksq = board.kingSquare(color);
+    for (int p = start + 1; p <= ply; p++) {
+        const UndoInfo& undo = history[p - 1];
+        const Move move = undo.move;
+        const PieceColor mover = colorOf(undo.moved);
+        const int16_t* adds[2];
+        const int16_t* subs[2];
+        int addCount = 0, subCount = 0;
+
+        subs[subCount++] = network_->column(featureIndex(color, ksq, undo.moved, move.from()));
+        PieceCode arriving = move.isPromotion() ? makePieceCode(move.promotionType(), mover) : undo.moved;
+        adds[addCount++] = network_->column(featureIndex(color, ksq, arriving, move.to()));
+        if (move.isCapture()) {
+            Square capturedSq = move.isEnpassant() ? move.to() + (mover == PieceColor::White ? -8 : 8) : move.to();
+            subs[subCount++] = network_->column(featureIndex(color, ksq, undo.captured, capturedSq));
+        } else if (move.isCastling()) {
+            Square rookFrom, rookTo;
+            castlingRookSquares(move, rookFrom, rookTo);
+            PieceCode rook = makePieceCode(PieceType::Rook, mover);
+            subs[subCount++] = network_->column(featureIndex(color, ksq, rook, rookFrom));
+            adds[addCount++] = network_->column(featureIndex(color, ksq, rook, rookTo));
+        }
+
+        const int16_t* src = stack_[p - 1].values[perspective];
+        network_->kernels_->update(claim(p), src, adds, addCount, subs, subCount);
+    }
+}
+
+} // namespace Nnue
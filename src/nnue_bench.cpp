@@ -0,0 +1,166 @@
+#include "Nnue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+constexpr int LINES_PER_FEN = 2000;
+constexpr int LINE_LENGTH = 12;
+constexpr int KERNEL_ITERATIONS = 2000000;
+
+struct Line {
+    const char* fen;
+    std::vector<Move> moves;
+};
+
+// Random games from each position, fixed so every instruction set does the same work.
+std::vector<Line> makeLines() {
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    auto random = [&state](size_t n) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return static_cast<size_t>((state * 0x2545F4914F6CDD1DULL) >> 32) % n;
+    };
+
+    std::vector<Line> lines;
+    for (const char* fen : FENS) {
+        Board board(PieceColor::White, fen);
+        for (int i = 0; i < LINES_PER_FEN; i++) {
+            Line line{fen, {}};
+            for (int ply = 0; ply < LINE_LENGTH; ply++) {
+                MoveList moves;
+                board.legalMoves(moves);
+                if (moves.empty()) break;
+                Move m = moves[random(moves.size())];
+                line.moves.push_back(m);
+                board.makeMove(m);
+            }
+            for (size_t ply = 0; ply < line.moves.size(); ply++) board.unmakeMove();
+            lines.push_back(std::move(line));
+        }
+    }
+    return lines;
+}
+
+struct Result {
+    uint64_t evals = 0;
+    int64_t checksum = 0;
+    double seconds = 0;
+};
+
+// Evaluate every position along every line, either through an Evaluator or from scratch.
+template <typename Eval>
+Result walk(const std::vector<Line>& lines, Eval eval) {
+    Result r;
+    auto start = std::chrono::steady_clock::now();
+    for (const Line& line : lines) {
+        Board board(PieceColor::White, line.fen);
+        r.checksum += eval(board);
+        for (Move m : line.moves) {
+            board.makeMove(m);
+            r.checksum += eval(board);
+        }
+        r.evals += line.moves.size() + 1;
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return r;
+}
+
+double perSecond(uint64_t count, double seconds) {
+    return seconds > 0 ? count / seconds : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Nnue::Network network;
+    if (argc > 1) {
+        std::string error;
+        if (!network.load(argv[1], error)) {
+            std::cerr << error << '\n';
+            return 1;
+        }
+    } else {
+        std::cout << "no weights file given, using random weights\n";
+        network.randomize(1);
+    }
+
+    const std::vector<Line> lines = makeLines();
+    std::printf("%-8s %14s %14s %14s %14s\n", "isa", "incremental/s", "full/s", "updates/s", "layer1/s");
+
+    bool consistent = true;
+    int64_t reference = 0;
+    const Nnue::Isa isas[] = {Nnue::Isa::Scalar, Nnue::Isa::Sse41, Nnue::Isa::Avx2};
+    for (Nnue::Isa isa : isas) {
+        if (!Nnue::isaSupported(isa)) {
+            std::printf("%-8s not supported on this CPU\n", Nnue::isaName(isa));
+            continue;
+        }
+        network.setIsa(isa);
+
+        Nnue::Evaluator evaluator(&network);
+        Result incremental = walk(lines, [&](const Board& b) { return evaluator.evaluate(b); });
+        Result full = walk(lines, [&](const Board& b) { return network.evaluate(b); });
+
+        // The kernels alone: a typical quiet move (one add, one sub) and the first dense layer.
+        const Nnue::Kernels& k = Nnue::kernels(isa);
+        alignas(64) int16_t acc[Nnue::HIDDEN] = {};
+        alignas(64) int16_t cols[2][Nnue::HIDDEN];
+        for (int i = 0; i < Nnue::HIDDEN; i++) {
+            cols[0][i] = static_cast<int16_t>(i % 7);
+            cols[1][i] = static_cast<int16_t>(i % 5);
+        }
+        const int16_t* add[1] = {cols[0]};
+        const int16_t* sub[1] = {cols[1]};
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < KERNEL_ITERATIONS; i++) k.update(acc, acc, add, 1, sub, 1);
+        double updateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        alignas(64) uint8_t input[Nnue::L1_INPUTS];
+        alignas(64) int8_t weights[Nnue::L1_OUTPUTS * Nnue::L1_INPUTS];
+        alignas(64) int32_t bias[Nnue::L1_OUTPUTS] = {};
+        alignas(64) int32_t out[Nnue::L1_OUTPUTS];
+        for (int i = 0; i < Nnue::L1_INPUTS; i++) input[i] = static_cast<uint8_t>(i % 128);
+        for (int i = 0; i < Nnue::L1_OUTPUTS * Nnue::L1_INPUTS; i++) weights[i] = static_cast<int8_t>(i % 31 - 15);
+        // Keeps the compiler from dropping the results.
+        volatile int32_t sink = acc[0];
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < KERNEL_ITERATIONS / 4; i++) {
+            input[i % Nnue::L1_INPUTS] = static_cast<uint8_t>(i & 127);
+            k.affine(input, weights, bias, out);
+            sink = sink + out[i % Nnue::L1_OUTPUTS];
+        }
+        double affineSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%-8s %14.0f %14.0f %14.0f %14.0f   (checksum %lld)\n", Nnue::isaName(isa),
+                    perSecond(incremental.evals, incremental.seconds), perSecond(full.evals, full.seconds),
+                    perSecond(KERNEL_ITERATIONS, updateSeconds), perSecond(KERNEL_ITERATIONS / 4, affineSeconds),
+                    static_cast<long long>(incremental.checksum));
+
+        if (incremental.checksum != full.checksum) {
+            std::printf("%-8s incremental and full evaluation disagree\n", Nnue::isaName(isa));
+            consistent = false;
+        }
+        if (isa == Nnue::Isa::Scalar) reference = incremental.checksum;
+        else if (incremental.checksum != reference) {
+            std::printf("%-8s result differs from the scalar kernels\n", Nnue::isaName(isa));
+            consistent = false;
+        }
+    }
+    return consistent ? 0 : 1;
+}
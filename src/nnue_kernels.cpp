@@ -0,0 +1,177 @@
+#include "Nnue.h"
+
+#include <algorithm>
+
+// The SIMD versions are compiled with per-function target attributes and picked at runtime, so
+// one binary runs everywhere and still uses AVX2 where the CPU has it.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NNUE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Nnue {
+
+namespace {
+
+void updateScalar(int16_t* dst, const int16_t* src, const int16_t* const* adds, int addCount,
+                  const int16_t* const* subs, int subCount) {
+    for (int i = 0; i < HIDDEN; i++) {
+        int16_t v = src[i];
+        for (int k = 0; k < subCount; k++) v = static_cast<int16_t>(v - subs[k][i]);
+        for (int k = 0; k < addCount; k++) v = static_cast<int16_t>(v + adds[k][i]);
+        dst[i] = v;
+    }
+}
+
+void transformScalar(const int16_t* us, const int16_t* them, uint8_t* out) {
+    for (int i = 0; i < HIDDEN; i++) {
+        out[i] = static_cast<uint8_t>(std::clamp<int>(us[i], 0, 127));
+        out[HIDDEN + i] = static_cast<uint8_t>(std::clamp<int>(them[i], 0, 127));
+    }
+}
+
+void affineScalar(const uint8_t* input, const int8_t* weights, const int32_t* bias, int32_t* out) {
+    for (int j = 0; j < L1_OUTPUTS; j++) {
+        const int8_t* row = weights + j * L1_INPUTS;
+        int32_t sum = bias[j];
+        for (int i = 0; i < L1_INPUTS; i++) sum += input[i] * row[i];
+        out[j] = sum;
+    }
+}
+
+#ifdef NNUE_X86
+
+__attribute__((target("sse4.1")))
+void updateSse41(int16_t* dst, const int16_t* src, const int16_t* const* adds, int addCount,
+                 const int16_t* const* subs, int subCount) {
+    for (int i = 0; i < HIDDEN; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        for (int k = 0; k < subCount; k++)
+            v = _mm_sub_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(subs[k] + i)));
+        for (int k = 0; k < addCount; k++)
+            v = _mm_add_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(adds[k] + i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+}
+
+__attribute__((target("sse4.1")))
+void transformSse41(const int16_t* us, const int16_t* them, uint8_t* out) {
+    const __m128i zero = _mm_setzero_si128();
+    const int16_t* halves[2] = {us, them};
+    for (int h = 0; h < 2; h++) {
+        for (int i = 0; i < HIDDEN; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(halves[h] + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(halves[h] + i + 8));
+            // Saturate to [-128, 127], then drop the negatives.
+            __m128i packed = _mm_max_epi8(_mm_packs_epi16(a, b), zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + h * HIDDEN + i), packed);
+        }
+    }
+}
+
+__attribute__((target("sse4.1")))
+void affineSse41(const uint8_t* input, const int8_t* weights, const int32_t* bias, int32_t* out) {
+    const __m128i ones = _mm_set1_epi16(1);
+    for (int j = 0; j < L1_OUTPUTS; j++) {
+        const int8_t* row = weights + j * L1_INPUTS;
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < L1_INPUTS; i += 16) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            // Inputs are at most 127, so the pairwise int16 sums cannot saturate.
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(in, w), ones));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        out[j] = bias[j] + _mm_cvtsi128_si32(sum);
+    }
+}
+
+__attribute__((target("avx2")))
+void updateAvx2(int16_t* dst, const int16_t* src, const int16_t* const* adds, int addCount,
+                const int16_t* const* subs, int subCount) {
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        for (int k = 0; k < subCount; k++)
+            v = _mm256_sub_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(subs[k] + i)));
+        for (int k = 0; k < addCount; k++)
+            v = _mm256_add_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(adds[k] + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+}
+
+__attribute__((target("avx2")))
+void transformAvx2(const int16_t* us, const int16_t* them, uint8_t* out) {
+    const __m256i zero = _mm256_setzero_si256();
+    const int16_t* halves[2] = {us, them};
+    for (int h = 0; h < 2; h++) {
+        for (int i = 0; i < HIDDEN; i += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(halves[h] + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(halves[h] + i + 16));
+            // packs works within 128-bit lanes; the permute restores the element order.
+            __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(a, b), zero);
+            packed = _mm256_permute4x64_epi64(packed, 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + h * HIDDEN + i), packed);
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void affineAvx2(const uint8_t* input, const int8_t* weights, const int32_t* bias, int32_t* out) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int j = 0; j < L1_OUTPUTS; j++) {
+        const int8_t* row = weights + j * L1_INPUTS;
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < L1_INPUTS; i += 32) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(in, w), ones));
+        }
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        out[j] = bias[j] + _mm_cvtsi128_si32(s);
+    }
+}
+
+#endif // NNUE_X86
+
+constexpr Kernels SCALAR_KERNELS = {updateScalar, transformScalar, affineScalar};
+#ifdef NNUE_X86
+constexpr Kernels SSE41_KERNELS = {updateSse41, transformSse41, affineSse41};
+constexpr Kernels AVX2_KERNELS = {updateAvx2, transformAvx2, affineAvx2};
+#endif
+
+} // namespace
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Avx2: return "avx2";
+    case Isa::Sse41: return "sse4.1";
+    default: return "scalar";
+    }
+}
+
+bool isaSupported(Isa isa) {
+#ifdef NNUE_X86
+    if (isa == Isa::Avx2) return __builtin_cpu_supports("avx2");
+    if (isa == Isa::Sse41) return __builtin_cpu_supports("sse4.1");
+#endif
+    return isa == Isa::Scalar;
+}
+
+Isa bestIsa() {
+    if (isaSupported(Isa::Avx2)) return Isa::Avx2;
+    if (isaSupported(Isa::Sse41)) return Isa::Sse41;
+    return Isa::Scalar;
+}
+
+const Kernels& kernels(Isa isa) {
+#ifdef NNUE_X86
+    if (isa == Isa::Avx2) return AVX2_KERNELS;
+    if (isa == Isa::Sse41) return SSE41_KERNELS;
+#endif
+    return SCALAR_KERNELS;
+}
+
+} // namespace Nnue
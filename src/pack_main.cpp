@@ -0,0 +1,129 @@
+#include "Epd.h"
+#include "PackedFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: pack [options] <input> <output>\n"
+              << "Convert FEN/EPD lines to a packed position file, 32 bytes per position, keeping the\n"
+              << "score of a 'ce' operation; or, with --unpack, a packed file back to FEN lines.\n"
+              << "options: --zlib       compress the chunks with zlib\n"
+              << "         --chunk N    positions per chunk (default 4096)\n"
+              << "         --unpack     read a packed file and write one FEN per line\n";
+}
+
+int pack(const std::string& inputPath, const std::string& outputPath, PackedCompression compression, uint32_t chunkSize,
+         uint64_t& positions) {
+    EpdReader reader;
+    PackedWriter writer;
+    std::string error;
+    if (!reader.open(inputPath, error) || !writer.open(outputPath, compression, error, chunkSize)) {
+        std::cerr << error << '\n';
+        return 2;
+    }
+
+    uint64_t skipped = 0;
+    EpdEntry entry;
+    PackedPosition packed;
+    while (reader.next(entry)) {
+        if (entry.error || !entry.board.pack(packed)) {
+            if (skipped++ < 10) std::cerr << inputPath << ':' << entry.lineNumber << ": skipped\n";
+            continue;
+        }
+        if (const EpdOperation* ce = entry.find("ce")) {
+            int score = 0;
+            const char* end = ce->operands.data() + ce->operands.size();
+            auto [ptr, ec] = std::from_chars(ce->operands.data(), end, score);
+            if (ec == std::errc() && ptr == end) packed.score = static_cast<int16_t>(std::clamp(score, -32767, 32767));
+        }
+        writer.write(packed);
+    }
+    if (!writer.close(error)) {
+        std::cerr << error << '\n';
+        return 1;
+    }
+    if (skipped) std::cerr << skipped << " lines skipped\n";
+    positions = writer.count();
+    return 0;
+}
+
+int unpack(const std::string& inputPath, const std::string& outputPath, uint64_t& positions) {
+    PackedReader reader;
+    std::string error;
+    if (!reader.open(inputPath, error)) {
+        std::cerr << error << '\n';
+        return 2;
+    }
+    reader.adviseSequential();
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "cannot create " << outputPath << '\n';
+        return 2;
+    }
+
+    Board board;
+    PackedPosition packed;
+    char fen[Board::FEN_BUFFER_SIZE];
+    for (uint64_t i = 0; i < reader.size(); i++) {
+        if (!reader.read(i, packed) || !board.unpack(packed)) {
+            std::cerr << inputPath << ": position " << i << " is corrupt\n";
+            return 1;
+        }
+        size_t length = board.toFEN(fen, sizeof(fen));
+        fen[length++] = '\n';
+        out.write(fen, static_cast<std::streamsize>(length));
+    }
+    out.flush();
+    if (!out) {
+        std::cerr << "error writing " << outputPath << '\n';
+        return 1;
+    }
+    positions = reader.size();
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    PackedCompression compression = PackedCompression::None;
+    uint32_t chunkSize = PackedWriter::DEFAULT_CHUNK_SIZE;
+    bool unpacking = false;
+    int arg = 1;
+    for (; arg < argc && std::string(argv[arg]).rfind("--", 0) == 0; arg++) {
+        std::string name = argv[arg];
+        if (name == "--zlib") {
+            compression = PackedCompression::Zlib;
+        } else if (name == "--unpack") {
+            unpacking = true;
+        } else if (name == "--chunk" && arg + 1 < argc) {
+            chunkSize = static_cast<uint32_t>(std::max(1L, std::atol(argv[++arg])));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (arg + 2 != argc) {
+        usage();
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t positions = 0;
+    int status = unpacking ? unpack(argv[arg], argv[arg + 1], positions)
+                           : pack(argv[arg], argv[arg + 1], compression, chunkSize, positions);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (status == 0) {
+        std::fprintf(stderr, "%llu positions in %.0f ms, %.0f positions/s\n", static_cast<unsigned long long>(positions),
+                     seconds * 1000, seconds > 0 ? positions / seconds : 0.0);
+    }
+    return status;
+}
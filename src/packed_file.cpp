@@ -0,0 +1,176 @@
+#include "PackedFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef CHESS_ZLIB
+#include <zlib.h>
+#endif
+
+bool packedZlibAvailable() {
+#ifdef CHESS_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+PackedWriter::~PackedWriter() {
+    std::string error;
+    if (out_.is_open()) close(error);
+}
+
+bool PackedWriter::open(const std::string& path, PackedCompression compression, std::string& error,
+                        uint32_t chunkSize) {
+    if (out_.is_open()) close(error);
+    if (compression == PackedCompression::Zlib && !packedZlibAvailable()) {
+        error = "zlib compression is not available in this build";
+        return false;
+    }
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        error = "cannot create " + path;
+        return false;
+    }
+
+    header_ = PackedFileHeader{};
+    std::memcpy(header_.magic, PackedFileHeader::MAGIC, sizeof(header_.magic));
+    header_.compression = compression;
+    header_.chunkSize = std::max<uint32_t>(1, chunkSize);
+    chunk_.clear();
+    chunk_.reserve(header_.chunkSize);
+    offsets_.clear();
+    count_ = 0;
+    failed_ = false;
+
+    // Rewritten with the final count and index position by close().
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    return true;
+}
+
+void PackedWriter::write(const PackedPosition& position) {
+    chunk_.push_back(position);
+    count_++;
+    if (chunk_.size() == header_.chunkSize) flushChunk();
+}
+
+void PackedWriter::flushChunk() {
+    if (chunk_.empty()) return;
+    const uint64_t offset = static_cast<uint64_t>(out_.tellp());
+    const char* raw = reinterpret_cast<const char*>(chunk_.data());
+    const size_t rawSize = chunk_.size() * sizeof(PackedPosition);
+
+#ifdef CHESS_ZLIB
+    if (header_.compression == PackedCompression::Zlib) {
+        uLongf size = compressBound(static_cast<uLong>(rawSize));
+        compressed_.resize(size);
+        if (compress2(compressed_.data(), &size, reinterpret_cast<const Bytef*>(raw), static_cast<uLong>(rawSize),
+                      Z_DEFAULT_COMPRESSION) != Z_OK) {
+            // close() reports it; the chunk is neither written nor indexed.
+            failed_ = true;
+        } else {
+            offsets_.push_back(offset);
+            out_.write(reinterpret_cast<const char*>(compressed_.data()), static_cast<std::streamsize>(size));
+        }
+        chunk_.clear();
+        return;
+    }
+#endif
+    offsets_.push_back(offset);
+    out_.write(raw, static_cast<std::streamsize>(rawSize));
+    chunk_.clear();
+}
+
+bool PackedWriter::close(std::string& error) {
+    if (!out_.is_open()) return true;
+    flushChunk();
+    offsets_.push_back(static_cast<uint64_t>(out_.tellp()));
+
+    header_.count = count_;
+    header_.indexOffset = offsets_.back();
+    out_.write(reinterpret_cast<const char*>(offsets_.data()), static_cast<std::streamsize>(offsets_.size() * sizeof(uint64_t)));
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    out_.close();
+
+    if (failed_ || !out_) {
+        error = failed_ ? "compression failed" : "error writing packed file";
+        return false;
+    }
+    return true;
+}
+
+bool PackedReader::open(const std::string& path, std::string& error) {
+    close();
+    if (!file_.open(path, error)) return false;
+
+    auto fail = [&](const char* message) {
+        error = path + ": " + message;
+        close();
+        return false;
+    };
+    if (file_.size() < sizeof(PackedFileHeader)) return fail("too short for a packed file");
+    std::memcpy(&header_, file_.data(), sizeof(header_));
+    if (std::memcmp(header_.magic, PackedFileHeader::MAGIC, sizeof(header_.magic)) != 0)
+        return fail("not a packed position file");
+    if (header_.compression != PackedCompression::None && header_.compression != PackedCompression::Zlib)
+        return fail("unknown compression");
+    if (header_.compression == PackedCompression::Zlib && !packedZlibAvailable())
+        return fail("compressed with zlib, which is not available in this build");
+    if (header_.chunkSize == 0) return fail("chunk size is 0");
+
+    // The index must fit the file and list increasing offsets between the header and itself.
+    const uint64_t chunks = (header_.count + header_.chunkSize - 1) / header_.chunkSize;
+    if (header_.indexOffset > file_.size() || (file_.size() - header_.indexOffset) / sizeof(uint64_t) != chunks + 1)
+        return fail("chunk index does not match the position count");
+    offsets_.resize(chunks + 1);
+    std::memcpy(offsets_.data(), file_.data() + header_.indexOffset, offsets_.size() * sizeof(uint64_t));
+    if (offsets_.front() != sizeof(PackedFileHeader) || offsets_.back() != header_.indexOffset
+        || !std::is_sorted(offsets_.begin(), offsets_.end()))
+        return fail("corrupt chunk index");
+    if (!compressed() && header_.indexOffset - sizeof(PackedFileHeader) != header_.count * sizeof(PackedPosition))
+        return fail("size does not match the position count");
+    return true;
+}
+
+void PackedReader::close() {
+    file_.close();
+    header_ = PackedFileHeader{};
+    offsets_.clear();
+    cache_.clear();
+    cachedChunk_ = SIZE_MAX;
+}
+
+bool PackedReader::read(uint64_t index, PackedPosition& out) {
+    if (!compressed()) {
+        out = data()[index];
+        return true;
+    }
+    const size_t chunk = static_cast<size_t>(index / header_.chunkSize);
+    if (chunk != cachedChunk_) {
+        cachedChunk_ = SIZE_MAX;
+        if (!readChunk(chunk, cache_)) return false;
+        cachedChunk_ = chunk;
+    }
+    out = cache_[index % header_.chunkSize];
+    return true;
+}
+
+bool PackedReader::readChunk(size_t chunk, std::vector<PackedPosition>& out) const {
+    const uint64_t first = static_cast<uint64_t>(chunk) * header_.chunkSize;
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(header_.chunkSize, header_.count - first));
+    out.resize(count);
+    const char* begin = file_.data() + offsets_[chunk];
+    const size_t size = offsets_[chunk + 1] - offsets_[chunk];
+
+#ifdef CHESS_ZLIB
+    if (compressed()) {
+        uLongf rawSize = static_cast<uLongf>(count * sizeof(PackedPosition));
+        return uncompress(reinterpret_cast<Bytef*>(out.data()), &rawSize, reinterpret_cast<const Bytef*>(begin),
+                          static_cast<uLong>(size)) == Z_OK
+            && rawSize == count * sizeof(PackedPosition);
+    }
+#endif
+    std::memcpy(out.data(), begin, std::min(size, count * sizeof(PackedPosition)));
+    return size == count * sizeof(PackedPosition);
+}
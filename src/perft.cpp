@@ -0,0 +1,220 @@
+#include "Perft.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+PerftTable::PerftTable(size_t megabytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) count *= 2;
+    entries_ = std::make_unique<Entry[]>(count);
+    mask_ = count - 1;
+}
+
+bool PerftTable::probe(uint64_t key, int depth, uint64_t& nodes) const {
+    const Entry& e = entries_[key & mask_];
+    uint64_t n = e.nodes.load(std::memory_order_relaxed);
+    if ((e.keyXorNodes.load(std::memory_order_relaxed) ^ n) != tag(key, depth)) return false;
+    nodes = n;
+    return true;
+}
+
+void PerftTable::store(uint64_t key, int depth, uint64_t nodes) {
+    Entry& e = entries_[key & mask_];
+    e.nodes.store(nodes, std::memory_order_relaxed);
+    e.keyXorNodes.store(tag(key, depth) ^ nodes, std::memory_order_relaxed);
+}
+
+uint64_t perft(Board& board, int depth, PerftTable* table) {
+    uint64_t key = board.key();
+    uint64_t cached;
+    if (table && depth > 1 && table->probe(key, depth, cached)) return cached;
+
+    MoveList moves;
+    board.legalMoves(moves);
+    if (depth <= 1) return depth == 1 ? moves.size() : 1;
+
+    uint64_t nodes = 0;
+    for (Move m : moves) {
+        board.makeMove(m);
+        nodes += perft(board, depth - 1, table);
+        board.unmakeMove();
+    }
+
+    if (table) table->store(key, depth, nodes);
+    return nodes;
+}
+
+std::vector<DivideEntry> divide(Board& board, int depth, PerftTable* table) {
+    std::vector<DivideEntry> result;
+    MoveList moves;
+    board.legalMoves(moves);
+    for (Move m : moves) {
+        board.makeMove(m);
+        result.push_back({m, perft(board, depth - 1, table)});
+        board.unmakeMove();
+    }
+    return result;
+}
+
+namespace {
+
+constexpr int MAX_SPLIT_PLY = 4;
+
+// The moves leading from the root to one subtree of a parallel perft.
+struct PerftTask {
+    Move moves[MAX_SPLIT_PLY];
+    int length;
+    int rootIndex; // index of moves[0] among the root moves
+};
+
+void collectTasks(Board& board, int plies, PerftTask& path, int rootIndex, std::vector<PerftTask>& tasks) {
+    if (path.length == plies) {
+        path.rootIndex = rootIndex;
+        tasks.push_back(path);
+        return;
+    }
+    MoveList moves;
+    board.legalMoves(moves);
+    for (size_t i = 0; i < moves.size(); i++) {
+        path.moves[path.length++] = moves[i];
+        board.makeMove(moves[i]);
+        collectTasks(board, plies, path, path.length == 1 ? static_cast<int>(i) : rootIndex, tasks);
+        board.unmakeMove();
+        path.length--;
+    }
+}
+
+// A contiguous run of task indices owned by one thread. The owner takes tasks from the front and
+// thieves take them from the back; both ends share one word, so a single CAS claims a task from
+// either side without locks.
+class TaskQueue {
+public:
+    void reset(uint32_t begin, uint32_t end) { bounds_.store(pack(begin, end), std::memory_order_relaxed); }
+
+    bool popFront(uint32_t& task) {
+        uint64_t b = bounds_.load(std::memory_order_relaxed);
+        while (front(b) < back(b)) {
+            if (bounds_.compare_exchange_weak(b, pack(front(b) + 1, back(b)), std::memory_order_relaxed)) {
+                task = front(b);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool popBack(uint32_t& task) {
+        uint64_t b = bounds_.load(std::memory_order_relaxed);
+        while (front(b) < back(b)) {
+            if (bounds_.compare_exchange_weak(b, pack(front(b), back(b) - 1), std::memory_order_relaxed)) {
+                task = back(b) - 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static uint64_t pack(uint32_t front, uint32_t back) { return static_cast<uint64_t>(front) << 32 | back; }
+    static uint32_t front(uint64_t b) { return static_cast<uint32_t>(b >> 32); }
+    static uint32_t back(uint64_t b) { return static_cast<uint32_t>(b); }
+
+    // Own cache line, so claims on one queue don't slow down the others.
+    alignas(64) std::atomic<uint64_t> bounds_{0};
+};
+
+} // namespace
+
+std::vector<DivideEntry> parallelDivide(const Board& board, int depth, int threads, int splitPly,
+                                        PerftTable* table, std::vector<PerftThreadStats>* stats) {
+    threads = std::max(threads, 1);
+    splitPly = std::clamp(splitPly, 1, std::min(MAX_SPLIT_PLY, std::max(depth - 1, 1)));
+
+    Board root = board;
+    MoveList rootMoves;
+    root.legalMoves(rootMoves);
+    std::vector<DivideEntry> result;
+    for (Move m : rootMoves) result.push_back({m, 0});
+    if (stats) stats->assign(threads, PerftThreadStats{});
+    if (depth <= 1) {
+        for (auto& e : result) e.nodes = 1;
+        return result;
+    }
+
+    std::vector<PerftTask> tasks;
+    PerftTask path{};
+    path.length = 0;
+    collectTasks(root, splitPly, path, 0, tasks);
+
+    const uint32_t taskCount = static_cast<uint32_t>(tasks.size());
+    std::vector<TaskQueue> queues(threads);
+    for (int t = 0; t < threads; t++)
+        queues[t].reset(static_cast<uint32_t>(uint64_t(taskCount) * t / threads),
+                        static_cast<uint32_t>(uint64_t(taskCount) * (t + 1) / threads));
+
+    // Each task's count is written by the one thread that ran it and summed after the join.
+    std::vector<uint64_t> taskNodes(taskCount, 0);
+    std::vector<PerftThreadStats> threadStats(threads);
+    const int remainingDepth = depth - splitPly;
+    const auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](int self) {
+        using Clock = std::chrono::steady_clock;
+        PerftThreadStats& st = threadStats[self];
+        Board local = root;
+        while (true) {
+            uint32_t task = 0;
+            bool stolen = false;
+            if (!queues[self].popFront(task)) {
+                // Steal from the back of the next non-empty queue, which holds the work its owner
+                // would reach last.
+                int victim = 1;
+                for (; victim < threads; victim++)
+                    if (queues[(self + victim) % threads].popBack(task)) break;
+                if (victim == threads) break;
+                stolen = true;
+            }
+
+            const auto taskStart = Clock::now();
+            const PerftTask& t = tasks[task];
+            for (int i = 0; i < t.length; i++) local.makeMove(t.moves[i]);
+            uint64_t nodes = perft(local, remainingDepth, table);
+            for (int i = 0; i < t.length; i++) local.unmakeMove();
+            taskNodes[task] = nodes;
+
+            st.tasks++;
+            st.stolen += stolen;
+            st.nodes += nodes;
+            st.busySeconds += std::chrono::duration<double>(Clock::now() - taskStart).count();
+        }
+        st.doneSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    for (uint32_t i = 0; i < taskCount; i++) result[tasks[i].rootIndex].nodes += taskNodes[i];
+    if (stats) *stats = std::move(threadStats);
+    return result;
+}
+
+const PerftPosition PERFT_SUITE[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603, 193690690}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624, 11030083, 178633661}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 15833292}},
+    {"position 4 mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+     {6, 264, 9467, 422333, 15833292}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487, 89941194}},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594, 164075551}},
+};
+
+const size_t PERFT_SUITE_SIZE = sizeof(PERFT_SUITE) / sizeof(PERFT_SUITE[0]);
@@ -0,0 +1,208 @@
+#include "Perft.h"
+#include "Epd.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct Options {
+    std::unique_ptr<PerftTable> table;
+    int threads = 1;
+    int splitPly = 2;
+};
+
+void usage() {
+    std::cerr << "usage: perft [options] <depth> [fen]\n"
+              << "       perft [options] suite [max depth]\n"
+              << "       perft [options] epd <file> [max depth]   check the file's D<depth> <nodes> counts;\n"
+              << "                                                 max depth 0 only times reading it\n"
+              << "options: --hash MB      share a perft hash table of MB megabytes\n"
+              << "         --threads N    count on N threads\n"
+              << "         --split PLY    split the tree into tasks PLY moves below the root (default 2)\n";
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint64_t nps(uint64_t nodes, double seconds) {
+    return seconds > 0 ? static_cast<uint64_t>(nodes / seconds) : 0;
+}
+
+void printThreadStats(const std::vector<PerftThreadStats>& stats) {
+    std::cout << "\nthread   tasks  stolen        nodes   busy ms   done ms\n";
+    for (size_t i = 0; i < stats.size(); i++) {
+        const PerftThreadStats& st = stats[i];
+        std::printf("%6zu %7llu %7llu %12llu %9llu %9llu\n", i, static_cast<unsigned long long>(st.tasks),
+                    static_cast<unsigned long long>(st.stolen), static_cast<unsigned long long>(st.nodes),
+                    static_cast<unsigned long long>(st.busySeconds * 1000),
+                    static_cast<unsigned long long>(st.doneSeconds * 1000));
+    }
+}
+
+// divide() or its parallel version, depending on the options.
+std::vector<DivideEntry> runPerft(Board& board, int depth, const Options& options,
+                                  std::vector<PerftThreadStats>* stats) {
+    if (options.threads <= 1) return divide(board, depth, options.table.get());
+    return parallelDivide(board, depth, options.threads, options.splitPly, options.table.get(), stats);
+}
+
+int runDivide(const std::string& fen, int depth, const Options& options) {
+    Board board;
+    FenError error;
+    if (!board.setFEN(fen, &error)) {
+        std::cerr << "invalid fen at offset " << error.offset << ": " << error.message << '\n';
+        return 2;
+    }
+    std::vector<PerftThreadStats> stats;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t total = 0;
+    for (const auto& e : runPerft(board, depth, options, &stats)) {
+        std::cout << toUci(e.move) << ": " << e.nodes << '\n';
+        total += e.nodes;
+    }
+    double seconds = secondsSince(start);
+    std::cout << "\nNodes searched: " << total << '\n'
+              << "Time: " << static_cast<uint64_t>(seconds * 1000) << " ms, NPS: " << nps(total, seconds) << '\n';
+    if (!stats.empty()) printThreadStats(stats);
+    return 0;
+}
+
+int runSuite(int maxDepth, const Options& options) {
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+    for (size_t i = 0; i < PERFT_SUITE_SIZE; i++) {
+        const PerftPosition& pos = PERFT_SUITE[i];
+        for (int depth = 1; depth <= maxDepth && depth <= 8 && pos.nodes[depth - 1]; depth++) {
+            Board board(PieceColor::White, pos.fen);
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = 0;
+            for (const auto& e : runPerft(board, depth, options, nullptr)) nodes += e.nodes;
+            double seconds = secondsSince(start);
+            totalNodes += nodes;
+            totalSeconds += seconds;
+
+            bool ok = nodes == pos.nodes[depth - 1];
+            if (!ok) failures++;
+            std::cout << (ok ? "ok   " : "FAIL ") << pos.name << " depth " << depth << ": " << nodes;
+            if (!ok) std::cout << " (expected " << pos.nodes[depth - 1] << ")";
+            std::cout << ", " << nps(nodes, seconds) << " nps\n";
+        }
+    }
+    std::cout << "\n" << (failures ? "FAILED " : "passed ") << totalNodes << " nodes in "
+              << static_cast<uint64_t>(totalSeconds * 1000) << " ms, " << nps(totalNodes, totalSeconds) << " nps\n";
+    return failures ? 1 : 0;
+}
+
+int runEpd(const std::string& path, int maxDepth, const Options& options) {
+    EpdReader reader;
+    std::string error;
+    if (!reader.open(path, error)) {
+        std::cerr << error << '\n';
+        return 2;
+    }
+
+    int failures = 0;
+    uint64_t records = 0, totalNodes = 0;
+    double readSeconds = 0, perftSeconds = 0;
+    EpdEntry entry;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        bool more = reader.next(entry);
+        readSeconds += secondsSince(start);
+        if (!more) break;
+        records++;
+        if (entry.error) {
+            std::cout << path << ':' << entry.lineNumber << ':' << entry.error.offset + 1 << ": "
+                      << entry.error.message << '\n';
+            failures++;
+            continue;
+        }
+
+        for (int depth = 1; depth <= maxDepth; depth++) {
+            char opcode[16];
+            std::snprintf(opcode, sizeof(opcode), "D%d", depth);
+            uint64_t expected = 0;
+            if (!entry.integer(opcode, expected)) continue;
+
+            start = std::chrono::steady_clock::now();
+            uint64_t nodes = 0;
+            for (const auto& e : runPerft(entry.board, depth, options, nullptr)) nodes += e.nodes;
+            perftSeconds += secondsSince(start);
+            totalNodes += nodes;
+            if (nodes != expected) {
+                failures++;
+                std::cout << "FAIL line " << entry.lineNumber << " depth " << depth << ": " << nodes
+                          << " (expected " << expected << ") " << entry.board.toFEN() << '\n';
+            }
+        }
+    }
+
+    std::cout << "read " << records << " records in " << static_cast<uint64_t>(readSeconds * 1000) << " ms ("
+              << nps(records, readSeconds) << " per second)\n";
+    if (maxDepth > 0)
+        std::cout << (failures ? "FAILED " : "passed ") << totalNodes << " nodes in "
+                  << static_cast<uint64_t>(perftSeconds * 1000) << " ms, " << nps(totalNodes, perftSeconds) << " nps\n";
+    return failures ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int arg = 1;
+    Options options;
+    for (; arg + 1 < argc && std::string(argv[arg]).rfind("--", 0) == 0; arg += 2) {
+        std::string name = argv[arg];
+        if (name == "--hash") {
+            options.table = std::make_unique<PerftTable>(std::strtoul(argv[arg + 1], nullptr, 10));
+        } else if (name == "--threads") {
+            options.threads = std::atoi(argv[arg + 1]);
+        } else if (name == "--split") {
+            options.splitPly = std::atoi(argv[arg + 1]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (arg >= argc) {
+        usage();
+        return 2;
+    }
+
+    std::string command = argv[arg++];
+    if (command == "suite") {
+        int maxDepth = arg < argc ? std::atoi(argv[arg]) : 8;
+        return runSuite(maxDepth, options);
+    }
+    if (command == "epd") {
+        if (arg >= argc) {
+            usage();
+            return 2;
+        }
+        std::string path = argv[arg++];
+        int maxDepth = arg < argc ? std::atoi(argv[arg]) : 8;
+        return runEpd(path, maxDepth, options);
+    }
+
+    int depth = std::atoi(command.c_str());
+    if (depth < 1) {
+        usage();
+        return 2;
+    }
+    // The FEN may be passed as one quoted argument or as its space-separated fields.
+    std::string fen;
+    for (; arg < argc; arg++) {
+        if (!fen.empty()) fen += ' ';
+        fen += argv[arg];
+    }
+    return runDivide(fen.empty() ? START_FEN : fen, depth, options);
+}
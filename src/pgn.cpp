@@ -0,0 +1,253 @@
+#include "Pgn.h"
+#include "San.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+bool isSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+// Characters that end a SAN token besides whitespace.
+bool isDelimiter(char ch) {
+    return isSpace(ch) || ch == '{' || ch == '}' || ch == '(' || ch == ')' || ch == ';' || ch == '$' || ch == '[';
+}
+
+// Offset of the first game starting at or after `from`: a '[' at the start of a line that
+// follows a blank line. The end of the text if there is none.
+size_t nextGameStart(std::string_view text, size_t from) {
+    while (true) {
+        size_t p = text.find("\n[", from);
+        if (p == std::string_view::npos) return text.size();
+        size_t q = p;
+        if (q > 0 && text[q - 1] == '\r') q--;
+        if (q > 0 && text[q - 1] == '\n') return p + 1;
+        from = p + 1;
+    }
+}
+
+} // namespace
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    for (int i = 0; i < tagCount; i++)
+        if (tags[i].name == name) return tags[i].value;
+    return {};
+}
+
+bool PgnReader::open(const std::string& path, std::string& error) {
+    if (!file_.open(path, error)) return false;
+    file_.adviseSequential();
+    text_ = file_.view();
+    pos_ = 0;
+    return true;
+}
+
+bool PgnReader::next(PgnGame& game) {
+    while (pos_ < text_.size() && isSpace(text_[pos_])) pos_++;
+    if (pos_ >= text_.size()) return false;
+
+    const size_t begin = pos_;
+    game.tagCount = 0;
+    game.moves.clear();
+    game.result = {};
+    game.error = nullptr;
+    game.errorOffset = 0;
+
+    readTags(game);
+    std::string_view fen = game.tag("FEN");
+    if (!game.start.setFEN(fen.empty() ? START_FEN : fen)) {
+        if (!game.error) {
+            game.error = "invalid FEN tag";
+            game.errorOffset = begin;
+        }
+        game.start.setFEN(START_FEN);
+    }
+    readMovetext(game);
+    game.text = text_.substr(begin, pos_ - begin);
+    if (game.error) game.errorOffset -= begin;
+    return true;
+}
+
+void PgnReader::readTags(PgnGame& game) {
+    while (pos_ < text_.size() && text_[pos_] == '[') {
+        const size_t tagStart = pos_;
+        size_t end = text_.find('\n', pos_);
+        if (end == std::string_view::npos) end = text_.size();
+
+        // [Name "value"] with the value's quotes and backslashes escaped.
+        size_t p = pos_ + 1;
+        while (p < end && isSpace(text_[p])) p++;
+        size_t nameStart = p;
+        while (p < end && !isSpace(text_[p]) && text_[p] != '"') p++;
+        std::string_view name = text_.substr(nameStart, p - nameStart);
+        while (p < end && isSpace(text_[p])) p++;
+        bool ok = !name.empty() && p < end && text_[p] == '"';
+        size_t valueStart = ++p;
+        while (ok && p < end && text_[p] != '"') p += text_[p] == '\\' ? 2 : 1;
+        ok = ok && p < end;
+        if (ok && game.tagCount < PgnGame::MAX_TAGS)
+            game.tags[game.tagCount++] = {name, text_.substr(valueStart, p - valueStart)};
+
+        pos_ = end;
+        while (pos_ < text_.size() && isSpace(text_[pos_])) pos_++;
+        if (!ok && !game.error) {
+            game.error = "malformed tag";
+            game.errorOffset = tagStart;
+        }
+    }
+}
+
+void PgnReader::readMovetext(PgnGame& game) {
+    board_ = game.start;
+    int depth = 0; // variation nesting
+
+    while (pos_ < text_.size()) {
+        const char ch = text_[pos_];
+        if (isSpace(ch)) {
+            pos_++;
+            continue;
+        }
+        const bool lineStart = pos_ == 0 || text_[pos_ - 1] == '\n';
+
+        if (ch == '{') {
+            size_t end = text_.find('}', pos_);
+            pos_ = end == std::string_view::npos ? text_.size() : end + 1;
+        } else if (ch == ';' || (ch == '%' && lineStart)) {
+            size_t end = text_.find('\n', pos_);
+            pos_ = end == std::string_view::npos ? text_.size() : end + 1;
+        } else if (ch == '(') {
+            depth++;
+            pos_++;
+        } else if (ch == ')') {
+            depth = std::max(0, depth - 1);
+            pos_++;
+        } else if (ch == '$') {
+            pos_++;
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') pos_++;
+        } else if (ch == '[') {
+            // At the start of a line, the next game's tags: this one ended without a result.
+            if (lineStart) break;
+            pos_++;
+        } else {
+            size_t start = pos_;
+            while (pos_ < text_.size() && !isDelimiter(text_[pos_])) pos_++;
+            if (pos_ == start) {
+                // A stray '}' or similar.
+                pos_++;
+                continue;
+            }
+            std::string_view token = text_.substr(start, pos_ - start);
+
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                if (depth == 0) {
+                    game.result = token;
+                    return;
+                }
+                continue;
+            }
+            // Move numbers ("12.", "12...", possibly run into the move as in "12.e4") and stray
+            // annotation glyphs. "0-0" is castling, not a number.
+            size_t digits = 0;
+            while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9') digits++;
+            if (digits == token.size()) continue;
+            if (digits > 0 && token[digits] == '.') token.remove_prefix(digits);
+            while (!token.empty() && token.front() == '.') token.remove_prefix(1);
+            if (token.empty() || token.front() == '!' || token.front() == '?' || depth > 0 || game.error) continue;
+
+            Move move = San::parse(board_, token);
+            if (move.isNull()) {
+                game.error = "illegal or ambiguous move";
+                game.errorOffset = static_cast<size_t>(token.data() - text_.data());
+                continue;
+            }
+            board_.makeMove(move);
+            game.moves.push_back(move);
+        }
+    }
+}
+
+void writePgn(const PgnGame& game, std::string& out) {
+    for (int i = 0; i < game.tagCount; i++) {
+        out += '[';
+        out += game.tags[i].name;
+        out += " \"";
+        out += game.tags[i].value;
+        out += "\"]\n";
+    }
+    out += '\n';
+
+    Board board = game.start;
+    size_t lineStart = out.size();
+    char token[32];
+    bool first = true;
+    auto append = [&](const char* text, size_t length) {
+        if (out.size() > lineStart && out.size() - lineStart + 1 + length > 79) {
+            out += '\n';
+            lineStart = out.size();
+        } else if (out.size() > lineStart) {
+            out += ' ';
+        }
+        out.append(text, length);
+    };
+
+    for (Move move : game.moves) {
+        if (board.getTurn() == PieceColor::White || first) {
+            int length = std::snprintf(token, sizeof(token), board.getTurn() == PieceColor::White ? "%d." : "%d...",
+                                       board.fullmoveNumber());
+            append(token, static_cast<size_t>(length));
+        }
+        first = false;
+        append(token, San::write(board, move, token));
+        board.makeMove(move);
+    }
+    std::string_view result = game.result.empty() ? std::string_view("*") : game.result;
+    append(result.data(), result.size());
+    out += "\n\n";
+}
+
+PgnStats readPgnParallel(std::string_view text, int threads,
+                         const std::function<void(int thread, const PgnGame& game)>& visit) {
+    threads = std::max(1, threads);
+    // Pieces much smaller than a thread's share, so threads finishing early can take more.
+    const size_t pieceSize = std::max<size_t>(1 << 20, text.size() / (static_cast<size_t>(threads) * 64));
+    std::vector<std::string_view> pieces;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t end = pos + pieceSize >= text.size() ? text.size() : nextGameStart(text, pos + pieceSize);
+        pieces.push_back(text.substr(pos, end - pos));
+        pos = end;
+    }
+
+    std::atomic<size_t> nextPiece{0};
+    std::vector<PgnStats> stats(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            PgnGame game;
+            PgnStats& st = stats[t];
+            for (size_t i; (i = nextPiece.fetch_add(1, std::memory_order_relaxed)) < pieces.size();) {
+                PgnReader reader(pieces[i]);
+                while (reader.next(game)) {
+                    st.games++;
+                    st.moves += game.moves.size();
+                    if (game.error) st.errors++;
+                    if (visit) visit(t, game);
+                }
+            }
+        });
+    }
+    for (auto& thread : pool) thread.join();
+
+    PgnStats total;
+    for (const PgnStats& st : stats) {
+        total.games += st.games;
+        total.moves += st.moves;
+        total.errors += st.errors;
+    }
+    return total;
+}
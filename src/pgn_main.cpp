@@ -0,0 +1,113 @@
+#include "Pgn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: pgn [options] <file>\n"
+              << "Read every game of <file>, resolving the main line's moves, and report the speed.\n"
+              << "options: --threads N    read on N threads (default 1)\n"
+              << "         --write FILE   write the games back out as PGN (one thread)\n";
+}
+
+// Line of `offset` in `text`, for error messages.
+size_t lineOf(std::string_view text, size_t offset) {
+    return 1 + static_cast<size_t>(std::count(text.begin(), text.begin() + offset, '\n'));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int threads = 1;
+    std::string writePath;
+    int arg = 1;
+    for (; arg + 1 < argc && std::string(argv[arg]).rfind("--", 0) == 0; arg += 2) {
+        std::string name = argv[arg];
+        if (name == "--threads") {
+            threads = std::max(1, std::atoi(argv[arg + 1]));
+        } else if (name == "--write") {
+            writePath = argv[arg + 1];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (arg + 1 != argc) {
+        usage();
+        return 2;
+    }
+
+    std::string path = argv[arg];
+    MappedFile input;
+    std::string error;
+    if (!input.open(path, error)) {
+        std::cerr << error << '\n';
+        return 2;
+    }
+    input.adviseSequential();
+    const std::string_view text = input.view();
+
+    // Only the first few errors are worth reading.
+    constexpr uint64_t MAX_REPORTED = 10;
+    std::mutex reportMutex;
+    uint64_t reported = 0;
+    auto report = [&](const PgnGame& game) {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        if (reported++ >= MAX_REPORTED) return;
+        size_t offset = static_cast<size_t>(game.text.data() - text.data()) + game.errorOffset;
+        std::string_view context = text.substr(offset, 20);
+        context = context.substr(0, context.find('\n'));
+        std::cerr << path << ':' << lineOf(text, offset) << ": " << game.error << " at '" << context << "'\n";
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    PgnStats stats;
+    if (writePath.empty()) {
+        stats = readPgnParallel(text, threads, [&](int, const PgnGame& game) {
+            if (game.error) report(game);
+        });
+    } else {
+        std::ofstream out(writePath, std::ios::binary);
+        if (!out) {
+            std::cerr << "cannot create " << writePath << '\n';
+            return 2;
+        }
+        PgnReader reader(text);
+        PgnGame game;
+        std::string buffer;
+        while (reader.next(game)) {
+            stats.games++;
+            stats.moves += game.moves.size();
+            if (game.error) {
+                stats.errors++;
+                report(game);
+            }
+            writePgn(game, buffer);
+            if (buffer.size() > (1 << 20)) {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (!out.flush()) {
+            std::cerr << "error writing " << writePath << '\n';
+            return 1;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%llu games, %llu moves, %llu with errors in %.0f ms: %.0f moves/s, %.1f MB/s on %d threads\n",
+                static_cast<unsigned long long>(stats.games), static_cast<unsigned long long>(stats.moves),
+                static_cast<unsigned long long>(stats.errors), seconds * 1000,
+                seconds > 0 ? stats.moves / seconds : 0.0, seconds > 0 ? text.size() / seconds / 1e6 : 0.0,
+                writePath.empty() ? threads : 1);
+    return stats.errors ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+#include "San.h"
+
+namespace {
+
+PieceType pieceFromLetter(char ch) {
+    switch (ch) {
+        case 'N': return PieceType::Knight;
+        case 'B': return PieceType::Bishop;
+        case 'R': return PieceType::Rook;
+        case 'Q': return PieceType::Queen;
+        case 'K': return PieceType::King;
+        default: return PieceType::None;
+    }
+}
+
+constexpr char PIECE_LETTERS[] = " PNBRQK";
+
+bool isFile(char ch) { return ch >= 'a' && ch <= 'h'; }
+bool isRank(char ch) { return ch >= '1' && ch <= '8'; }
+
+Square parseSquare(char file, char rank) {
+    return (rank - '1') * 8 + (file - 'a');
+}
+
+// Pieces of `type` and color `us` that could move to `to`, ignoring pins and checks. Pawns are
+// handled by the caller.
+Bitboard pieceSources(const Board& board, PieceType type, PieceColor us, Square to) {
+    using namespace Bitboards;
+    Bitboard occupied = board.occupied();
+    Bitboard attackers = 0;
+    switch (type) {
+        case PieceType::Knight: attackers = KnightAttacks[to]; break;
+        case PieceType::Bishop: attackers = bishopAttacks(to, occupied); break;
+        case PieceType::Rook: attackers = rookAttacks(to, occupied); break;
+        case PieceType::Queen: attackers = queenAttacks(to, occupied); break;
+        case PieceType::King: attackers = KingAttacks[to]; break;
+        default: break;
+    }
+    return attackers & board.pieces(type, us);
+}
+
+Move parseCastling(const Board& board, bool queenside) {
+    const PieceColor us = board.getTurn();
+    const Square king = us == PieceColor::White ? makeSquare(7, 4) : makeSquare(0, 4);
+    const uint8_t right = us == PieceColor::White ? (queenside ? WHITE_OOO : WHITE_OO)
+                                                  : (queenside ? BLACK_OOO : BLACK_OO);
+    if (board.kingSquare(us) != king || !(board.getCastlingRights() & right)) return Move{};
+    // Squares between king and rook: b-d for queenside, f-g for kingside.
+    Bitboard path = queenside ? squareBB(king - 1) | squareBB(king - 2) | squareBB(king - 3)
+                              : squareBB(king + 1) | squareBB(king + 2);
+    if (board.occupied() & path) return Move{};
+    Move move = queenside ? Move(king, king - 2, Move::QueenCastle) : Move(king, king + 2, Move::KingCastle);
+    return board.isLegal(move) ? move : Move{};
+}
+
+} // namespace
+
+namespace San {
+
+Move parse(const Board& board, std::string_view san) {
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+        san.remove_suffix(1);
+    if (san == "O-O" || san == "0-0") return parseCastling(board, false);
+    if (san == "O-O-O" || san == "0-0-0") return parseCastling(board, true);
+
+    PieceType promotion = PieceType::None;
+    if (san.size() >= 3 && pieceFromLetter(san.back()) != PieceType::None && san.back() != 'K') {
+        promotion = pieceFromLetter(san.back());
+        san.remove_suffix(1);
+        if (san.back() == '=') san.remove_suffix(1);
+    }
+    if (san.size() < 2 || !isFile(san[san.size() - 2]) || !isRank(san.back())) return Move{};
+    const Square to = parseSquare(san[san.size() - 2], san.back());
+    san.remove_suffix(2);
+
+    PieceType type = PieceType::Pawn;
+    if (!san.empty() && pieceFromLetter(san.front()) != PieceType::None) {
+        type = pieceFromLetter(san.front());
+        san.remove_prefix(1);
+    }
+    bool capture = false;
+    if (!san.empty() && san.back() == 'x') {
+        capture = true;
+        san.remove_suffix(1);
+    }
+    // What is left is the disambiguation: a file, a rank or a square.
+    Bitboard fromMask = ~0ULL;
+    for (char ch : san) {
+        if (isFile(ch)) fromMask &= FILE_A_BB << (ch - 'a');
+        else if (isRank(ch)) fromMask &= RANK_1_BB << (8 * (ch - '1'));
+        else return Move{};
+    }
+    if (san.size() > 2) return Move{};
+
+    const PieceColor us = board.getTurn();
+    const PieceColor them = opposite(us);
+    const Bitboard own = board.pieces(us);
+    if (own & squareBB(to)) return Move{};
+    if ((promotion != PieceType::None) != (type == PieceType::Pawn && (rankOf(to) == 0 || rankOf(to) == 7)))
+        return Move{};
+
+    unsigned flags = (board.pieces(them) & squareBB(to)) ? Move::Capture : Move::Quiet;
+    Bitboard sources;
+    if (type == PieceType::Pawn) {
+        const int up = us == PieceColor::White ? 8 : -8;
+        const Bitboard pawns = board.pieces(PieceType::Pawn, us);
+        if (capture || san.size() == 1) {
+            if (to == board.enPassantSquare()) flags = Move::EnPassant;
+            else if (flags != Move::Capture) return Move{};
+            sources = Bitboards::pawnAttacks(them, to) & pawns;
+        } else {
+            if (flags == Move::Capture) return Move{};
+            if (rankOf(to) == (us == PieceColor::White ? 0 : 7)) return Move{};
+            sources = pawns & squareBB(to - up);
+            // A double push lands on the fourth rank and needs the square it passes over empty.
+            int doublePushRank = us == PieceColor::White ? 3 : 4;
+            if (!sources && rankOf(to) == doublePushRank && !(board.occupied() & squareBB(to - up))) {
+                sources = pawns & squareBB(to - 2 * up);
+                flags = Move::DoublePush;
+            }
+        }
+        if (promotion != PieceType::None) {
+            Promotion pr = static_cast<Promotion>(static_cast<int>(promotion) - static_cast<int>(PieceType::Knight) + 1);
+            flags = promotionFlags(pr, flags == Move::Capture);
+        }
+    } else {
+        sources = pieceSources(board, type, us, to);
+    }
+
+    // Usually one candidate; a second one is only legal if the first is pinned.
+    Move found{};
+    sources &= fromMask;
+    while (sources) {
+        Move move(popLsb(sources), to, flags);
+        if (!board.isLegal(move)) continue;
+        if (!found.isNull()) return Move{};
+        found = move;
+    }
+    return found;
+}
+
+size_t write(Board& board, Move move, char* out) {
+    char* p = out;
+    const Square from = move.from();
+    const Square to = move.to();
+    const PieceType type = typeOf(board.pieceOn(from));
+
+    if (move.isCastling()) {
+        const char* text = move.flags() == Move::KingCastle ? "O-O" : "O-O-O";
+        while (*text) *p++ = *text++;
+    } else {
+        if (type == PieceType::Pawn) {
+            if (move.isCapture()) *p++ = static_cast<char>('a' + fileOf(from));
+        } else {
+            *p++ = PIECE_LETTERS[static_cast<int>(type)];
+            // Other legal moves of the same piece type to the same square decide how much of the
+            // origin to spell out: the file if it is unique, else the rank, else both.
+            Bitboard others = pieceSources(board, type, board.getTurn(), to) & ~squareBB(from);
+            Bitboard rivals = 0;
+            while (others) {
+                Square sq = popLsb(others);
+                if (board.isLegal(Move(sq, to, move.flags()))) rivals |= squareBB(sq);
+            }
+            if (rivals) {
+                if (!(rivals & fileBB(from))) {
+                    *p++ = static_cast<char>('a' + fileOf(from));
+                } else if (!(rivals & rankBB(from))) {
+                    *p++ = static_cast<char>('1' + rankOf(from));
+                } else {
+                    *p++ = static_cast<char>('a' + fileOf(from));
+                    *p++ = static_cast<char>('1' + rankOf(from));
+                }
+            }
+        }
+        if (move.isCapture()) *p++ = 'x';
+        *p++ = static_cast<char>('a' + fileOf(to));
+        *p++ = static_cast<char>('1' + rankOf(to));
+        if (move.isPromotion()) {
+            *p++ = '=';
+            *p++ = PIECE_LETTERS[static_cast<int>(move.promotionType())];
+        }
+    }
+
+    board.makeMove(move);
+    if (board.checkers()) *p++ = board.hasAnyLegalMove() ? '+' : '#';
+    board.unmakeMove();
+    *p = '\0';
+    return static_cast<size_t>(p - out);
+}
+
+std::string toSan(Board& board, Move move) {
+    char buffer[BUFFER_SIZE];
+    return std::string(buffer, write(board, move, buffer));
+}
+
+} // namespace San
@@ -0,0 +1,533 @@
+#include "Search.h"
+#include "Evaluate.h"
+#include "MovePicker.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+constexpr int colorIndex(PieceColor c) { return c == PieceColor::White ? 0 : 1; }
+
+// Mate and tablebase scores are stored relative to the node rather than the root, so a TT hit
+// at another ply still reports the right distance.
+int scoreToTT(int score, int ply) {
+    if (score >= VALUE_TB_WIN_IN_MAX_PLY) return score + ply;
+    if (score <= -VALUE_TB_WIN_IN_MAX_PLY) return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score >= VALUE_TB_WIN_IN_MAX_PLY) return score - ply;
+    if (score <= -VALUE_TB_WIN_IN_MAX_PLY) return score + ply;
+    return score;
+}
+
+constexpr int HISTORY_MAX = 16384;
+
+// Helper threads skip some iterations so that at any moment the threads are spread over a few
+// neighbouring depths instead of all racing on the same one. Helper i skips depth d when
+// ((d + SKIP_PHASE[i]) / SKIP_SIZE[i]) is odd.
+constexpr int SKIP_COUNT = 20;
+constexpr int SKIP_SIZE[SKIP_COUNT] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int SKIP_PHASE[SKIP_COUNT] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+} // namespace
+
+class Search::HelperThread {
+public:
+    explicit HelperThread(std::function<void()> job) : job_(std::move(job)), thread_([this] { idleLoop(); }) {
+        wait();
+    }
+
+    ~HelperThread() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exit_ = true;
+            searching_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void start() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            searching_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    // Block until the job has returned.
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !searching_; });
+    }
+
+private:
+    void idleLoop() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            searching_ = false;
+            cv_.notify_all();
+            cv_.wait(lock, [this] { return searching_; });
+            if (exit_) return;
+            lock.unlock();
+            job_();
+        }
+    }
+
+    std::function<void()> job_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool searching_ = true;
+    bool exit_ = false;
+    std::thread thread_; // last, so it starts after everything above is constructed
+};
+
+std::string formatInfo(const SearchInfo& info) {
+    std::string s = "info depth " + std::to_string(info.depth) + " seldepth " + std::to_string(info.seldepth);
+    if (std::abs(info.score) >= VALUE_MATE_IN_MAX_PLY) {
+        int moves = info.score > 0 ? (VALUE_MATE - info.score + 1) / 2 : -(VALUE_MATE + info.score) / 2;
+        s += " score mate " + std::to_string(moves);
+    } else {
+        s += " score cp " + std::to_string(info.score);
+    }
+    s += " nodes " + std::to_string(info.nodes) + " nps " + std::to_string(info.nps);
+    if (info.tbHits) s += " tbhits " + std::to_string(info.tbHits);
+    s += " hashfull " + std::to_string(info.hashfull) + " time " + std::to_string(info.timeMs) + " pv";
+    for (Move m : info.pv) s += " " + toUci(m);
+    return s;
+}
+
+Search::Search(TranspositionTable& tt, int threads) : tt_(tt) {
+    setThreads(threads);
+}
+
+Search::~Search() {
+    stop();
+    wait();
+    helpers_.clear();
+}
+
+void Search::setThreads(int count) {
+    count = std::max(count, 1);
+    helpers_.clear();
+    workers_.clear();
+    for (int i = 0; i < count; i++) workers_.push_back(std::make_unique<SearchWorker>(*this, i));
+    for (int i = 1; i < count; i++) {
+        SearchWorker* worker = workers_[i].get();
+        helpers_.push_back(std::make_unique<HelperThread>([worker] { worker->iterate(); }));
+    }
+}
+
+SearchResult Search::run(const Board& root, const SearchLimits& limits) {
+    stop_.store(false, std::memory_order_relaxed);
+    return think(root, limits);
+}
+
+void Search::start(const Board& root, const SearchLimits& limits, std::function<void(const SearchResult&)> done) {
+    wait();
+    // Cleared here rather than on the new thread, so a stop() right after start() can't be lost.
+    stop_.store(false, std::memory_order_relaxed);
+    background_ = std::thread([this, root, limits, done = std::move(done)] { done(think(root, limits)); });
+}
+
+void Search::wait() {
+    if (background_.joinable()) background_.join();
+}
+
+SearchResult Search::think(const Board& root, const SearchLimits& limits) {
+    start_ = Clock::now();
+    root_ = root;
+    limits_ = limits;
+    setupTimeControl(limits, root.getTurn());
+    tt_.newSearch();
+
+    SearchResult result;
+    rootMoves_.clear();
+    root_.legalMoves(rootMoves_);
+    if (rootMoves_.empty()) {
+        result.score = root_.checkers() ? -VALUE_MATE : VALUE_DRAW;
+        return result;
+    }
+    // The search alone cannot see the fifty-move rule coming; DTZ keeps only moves that make
+    // progress, and leaves the search to choose among them.
+    if (tablebases_) tablebases_->filterRootMoves(root_, rootMoves_);
+
+    for (auto& worker : workers_) {
+        worker->nodes_.store(0, std::memory_order_relaxed);
+        worker->tbHits_.store(0, std::memory_order_relaxed);
+        worker->completedDepth_ = 0;
+        worker->completedPv_.length = 0;
+        worker->nnue_.setNetwork(network_);
+    }
+    for (auto& helper : helpers_) helper->start();
+    workers_[0]->iterate();
+
+    // The main thread decides when the search is over; pull the helpers out of whatever
+    // iteration they are in.
+    stop_.store(true, std::memory_order_relaxed);
+    for (auto& helper : helpers_) helper->wait();
+
+    const SearchWorker& best = voteBestThread();
+    if (best.completedPv_.length > 0) {
+        result.bestMove = best.completedPv_.moves[0];
+        result.ponderMove = best.completedPv_.length > 1 ? best.completedPv_.moves[1] : Move{};
+        result.score = best.completedScore_;
+        result.depth = best.completedDepth_;
+    } else {
+        // Something to play even if no iteration completed.
+        result.bestMove = rootMoves_[0];
+    }
+    result.nodes = totalNodes();
+    for (const auto& worker : workers_) result.threadNodes.push_back(worker->nodes());
+    return result;
+}
+
+const SearchWorker& Search::voteBestThread() const {
+    const SearchWorker* best = workers_[0].get();
+    if (workers_.size() == 1) return *best;
+
+    int minScore = VALUE_INFINITE;
+    for (const auto& w : workers_) {
+        if (w->completedPv_.length) minScore = std::min(minScore, w->completedScore_);
+    }
+
+    // Each thread votes for its move with a weight that grows with its depth and with how much
+    // better its score is than the worst one.
+    auto votes = [&](Move m) {
+        int64_t total = 0;
+        for (const auto& w : workers_) {
+            if (w->completedPv_.length && w->completedPv_.moves[0] == m)
+                total += static_cast<int64_t>(w->completedScore_ - minScore + 14) * w->completedDepth_;
+        }
+        return total;
+    };
+
+    for (const auto& w : workers_) {
+        const SearchWorker* th = w.get();
+        if (th == best || !th->completedPv_.length) continue;
+        if (!best->completedPv_.length) {
+            best = th;
+            continue;
+        }
+        // Proven mates trump votes: take the quickest win, and never trade a win for a guess.
+        if (std::abs(best->completedScore_) >= VALUE_MATE_IN_MAX_PLY) {
+            if (th->completedScore_ > best->completedScore_) best = th;
+        } else if (th->completedScore_ >= VALUE_MATE_IN_MAX_PLY
+                   || (th->completedScore_ > VALUE_MATED_IN_MAX_PLY
+                       && votes(th->completedPv_.moves[0]) > votes(best->completedPv_.moves[0]))) {
+            best = th;
+        }
+    }
+    return *best;
+}
+
+void Search::report(const SearchWorker& main, int depth, int score, const PvLine& pv) {
+    SearchInfo info;
+    info.depth = depth;
+    info.seldepth = main.seldepth_;
+    info.score = score;
+    info.nodes = totalNodes();
+    info.timeMs = elapsedMs();
+    info.nps = info.nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(info.timeMs, 1));
+    info.tbHits = totalTbHits();
+    info.hashfull = tt_.hashfull();
+    info.pv.assign(pv.moves, pv.moves + pv.length);
+    for (const auto& worker : workers_) info.threadNodes.push_back(worker->nodes());
+    onInfo(info);
+}
+
+void SearchWorker::iterate() {
+    board_ = owner_.root_;
+    std::memset(killers_, 0, sizeof(killers_));
+    std::memset(history_, 0, sizeof(history_));
+
+    const SearchLimits& limits = owner_.limits_;
+    const int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+    int previousScore = 0;
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        if (!isMainThread()) {
+            int i = (index_ - 1) % SKIP_COUNT;
+            if (((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2) continue;
+        }
+        seldepth_ = 0;
+
+        // Aspiration window around the previous score, widened on each fail.
+        int delta = 25;
+        int alpha = -VALUE_INFINITE, beta = VALUE_INFINITE;
+        if (depth >= 5) {
+            alpha = std::max(previousScore - delta, -VALUE_INFINITE);
+            beta = std::min(previousScore + delta, VALUE_INFINITE);
+        }
+
+        PvLine pv;
+        int score;
+        while (true) {
+            score = search(depth, alpha, beta, 0, true, pv);
+            if (stopped()) break;
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -VALUE_INFINITE);
+            } else if (score >= beta) {
+                beta = std::min(score + delta, VALUE_INFINITE);
+            } else {
+                break;
+            }
+            delta += delta / 2;
+        }
+
+        // An interrupted iteration is not trusted, except for depth 1 which always completes
+        // far enough to have found a move.
+        if (stopped() && (depth > 1 || pv.length == 0)) break;
+
+        completedDepth_ = depth;
+        completedScore_ = score;
+        completedPv_ = pv;
+        previousScore = score;
+
+        if (!isMainThread()) {
+            if (stopped()) break;
+            continue;
+        }
+
+        if (owner_.onInfo) owner_.report(*this, depth, score, pv);
+
+        if (stopped()) break;
+        // Don't start an iteration we are unlikely to finish.
+        if (owner_.softLimitMs_ && owner_.elapsedMs() >= owner_.softLimitMs_) break;
+        // A forced mate that fits in the completed depth will not change with more depth.
+        if (!limits.infinite && std::abs(score) >= VALUE_MATE_IN_MAX_PLY && VALUE_MATE - std::abs(score) <= depth) break;
+    }
+}
+
+int SearchWorker::staticEval() {
+    return nnue_.network() ? nnue_.evaluate(board_) : evaluate(board_);
+}
+
+bool SearchWorker::stopped() const {
+    return owner_.stop_.load(std::memory_order_relaxed);
+}
+
+void SearchWorker::visitNode() {
+    uint64_t n = nodes_.load(std::memory_order_relaxed) + 1;
+    nodes_.store(n, std::memory_order_relaxed);
+    if (isMainThread() && (n & 2047) == 0) owner_.checkLimits();
+}
+
+int SearchWorker::search(int depth, int alpha, int beta, int ply, bool pvNode, PvLine& pv) {
+    pv.length = 0;
+    const bool rootNode = ply == 0;
+    const Bitboard checkers = board_.checkers();
+
+    // Extend checks so the quiescence search never starts in check.
+    if (checkers) depth++;
+    if (depth <= 0) return quiesce(alpha, beta, ply);
+
+    visitNode();
+    if (stopped()) return 0;
+    seldepth_ = std::max(seldepth_, ply);
+
+    if (!rootNode) {
+        if (board_.halfmoveClock() >= 100 || board_.isRepetition() || board_.hasInsufficientMaterial()) return VALUE_DRAW;
+        if (ply >= MAX_PLY - 1) return checkers ? VALUE_DRAW : staticEval();
+
+        // Mate distance pruning: no line from here can beat a mate already found nearer the root.
+        alpha = std::max(alpha, -VALUE_MATE + ply);
+        beta = std::min(beta, VALUE_MATE - ply - 1);
+        if (alpha >= beta) return alpha;
+    }
+
+    const uint64_t key = board_.key();
+    TTData tte;
+    const bool ttHit = owner_.tt_.probe(key, tte);
+    const Move ttMove = ttHit ? tte.move : Move{};
+    if (ttHit && !pvNode && tte.depth >= depth) {
+        int ttScore = scoreFromTT(tte.score, ply);
+        if (tte.bound == Bound::Exact
+            || (tte.bound == Bound::Lower && ttScore >= beta)
+            || (tte.bound == Bound::Upper && ttScore <= alpha))
+            return ttScore;
+    }
+
+    // Right after a capture or pawn move the WDL tables are exact under the fifty-move rule, so
+    // their result is as good as a search of any depth.
+    const Syzygy::Tablebases* tablebases = owner_.tablebases_;
+    if (!rootNode && tablebases && board_.halfmoveClock() == 0 && tablebases->covers(board_)) {
+        Syzygy::Wdl wdl;
+        if (tablebases->probeWdl(board_, wdl)) {
+            tbHits_.store(tbHits_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            int score = wdl == Syzygy::Win ? VALUE_TB_WIN - ply : wdl == Syzygy::Loss ? -VALUE_TB_WIN + ply : VALUE_DRAW + 2 * wdl;
+            Bound bound = wdl == Syzygy::Win ? Bound::Lower : wdl == Syzygy::Loss ? Bound::Upper : Bound::Exact;
+            if (bound == Bound::Exact || (bound == Bound::Lower ? score >= beta : score <= alpha)) {
+                owner_.tt_.store(key, std::min(depth + 6, MAX_PLY - 1), bound, scoreToTT(score, ply), VALUE_NONE, Move{});
+                return score;
+            }
+        }
+    }
+
+    int eval = VALUE_NONE;
+    if (!checkers) eval = ttHit && tte.eval != VALUE_NONE ? tte.eval : staticEval();
+
+    MovePicker picker(board_, ttMove, killers_[ply], history_[colorIndex(board_.getTurn())]);
+
+    const int originalAlpha = alpha;
+    int bestScore = -VALUE_INFINITE;
+    Move bestMove{};
+    Move quiets[64];
+    int quietCount = 0;
+    int moveCount = 0;
+    PvLine childPv;
+
+    for (Move m = picker.next(); !m.isNull(); m = picker.next()) {
+        if (rootNode && !owner_.rootMoves_.contains(m)) continue;
+        const bool quiet = !m.isCapture() && !m.isPromotion();
+
+        board_.makeMove(m);
+        owner_.tt_.prefetch(board_.key());
+
+        int score;
+        if (moveCount++ == 0) {
+            score = -search(depth - 1, -beta, -alpha, ply + 1, pvNode, childPv);
+        } else {
+            // Principal variation search: prove the move is no better with a null window, and
+            // only re-search with the full window when it is.
+            score = -search(depth - 1, -alpha - 1, -alpha, ply + 1, false, childPv);
+            if (pvNode && score > alpha && score < beta)
+                score = -search(depth - 1, -beta, -alpha, ply + 1, true, childPv);
+        }
+
+        board_.unmakeMove();
+        if (stopped()) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                bestMove = m;
+                alpha = score;
+                pv.moves[0] = m;
+                std::copy(childPv.moves, childPv.moves + childPv.length, pv.moves + 1);
+                pv.length = childPv.length + 1;
+                if (score >= beta) break;
+            }
+        }
+        if (quiet && quietCount < 64) quiets[quietCount++] = m;
+    }
+    if (moveCount == 0) return checkers ? -VALUE_MATE + ply : VALUE_DRAW;
+
+    if (bestScore >= beta && !bestMove.isCapture() && !bestMove.isPromotion())
+        updateQuietStats(bestMove, depth, ply, quiets, quietCount);
+
+    Bound bound = bestScore >= beta ? Bound::Lower : bestScore > originalAlpha ? Bound::Exact : Bound::Upper;
+    owner_.tt_.store(key, depth, bound, scoreToTT(bestScore, ply), eval, bestMove);
+    return bestScore;
+}
+
+int SearchWorker::quiesce(int alpha, int beta, int ply) {
+    visitNode();
+    if (stopped()) return 0;
+    seldepth_ = std::max(seldepth_, ply);
+
+    if (board_.halfmoveClock() >= 100 || board_.isRepetition() || board_.hasInsufficientMaterial()) return VALUE_DRAW;
+    const bool inCheck = board_.checkers() != 0;
+    if (ply >= MAX_PLY - 1) return inCheck ? VALUE_DRAW : staticEval();
+
+    // Stand pat: the side to move can usually do at least as well as the static eval by not
+    // capturing. When in check every evasion is searched instead.
+    int bestScore = -VALUE_INFINITE;
+    if (!inCheck) {
+        bestScore = staticEval();
+        if (bestScore >= beta) return bestScore;
+        alpha = std::max(alpha, bestScore);
+    }
+
+    // Captures and queen promotions only, or every evasion when in check. Stalemates are not
+    // detected here; that would need every quiet move generated.
+    MovePicker picker(board_, Move{});
+    int moveCount = 0;
+    for (Move m = picker.next(); !m.isNull(); m = picker.next()) {
+        moveCount++;
+        board_.makeMove(m);
+        int score = -quiesce(-beta, -alpha, ply + 1);
+        board_.unmakeMove();
+        if (stopped()) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (score >= beta) break;
+            }
+        }
+    }
+    if (inCheck && moveCount == 0) return -VALUE_MATE + ply;
+    return bestScore;
+}
+
+void SearchWorker::updateQuietStats(Move best, int depth, int ply, const Move* quiets, int quietCount) {
+    if (killers_[ply][0] != best) {
+        killers_[ply][1] = killers_[ply][0];
+        killers_[ply][0] = best;
+    }
+
+    // History gravity: entries move toward +/-HISTORY_MAX and saturate there.
+    const int us = colorIndex(board_.getTurn());
+    const int bonus = std::min(depth * depth, 400);
+    auto update = [&](Move m, int delta) {
+        int& h = history_[us][m.from()][m.to()];
+        h += delta - h * std::abs(delta) / HISTORY_MAX;
+    };
+    update(best, bonus);
+    for (int i = 0; i < quietCount; i++) {
+        if (quiets[i] != best) update(quiets[i], -bonus);
+    }
+}
+
+void Search::setupTimeControl(const SearchLimits& limits, PieceColor us) {
+    softLimitMs_ = 0;
+    hardLimitMs_ = 0;
+    if (limits.infinite) return;
+    if (limits.movetime > 0) {
+        softLimitMs_ = hardLimitMs_ = limits.movetime;
+        return;
+    }
+
+    const int64_t remaining = limits.time[colorIndex(us)];
+    if (remaining <= 0) return;
+    const int64_t increment = limits.increment[colorIndex(us)];
+    const int64_t overhead = 30;
+    const int movesToGo = limits.movestogo > 0 ? std::min(limits.movestogo, 40) : 30;
+
+    // Aim for an even share of the clock; allow overrunning it a few times over within one
+    // iteration, but never come close to flagging.
+    softLimitMs_ = remaining / movesToGo + increment * 3 / 4;
+    hardLimitMs_ = std::min(softLimitMs_ * 4, remaining / 2 + increment / 2);
+    hardLimitMs_ = std::max<int64_t>(1, std::min(hardLimitMs_, remaining - overhead));
+    softLimitMs_ = std::max<int64_t>(1, std::min(softLimitMs_, hardLimitMs_));
+}
+
+uint64_t Search::totalNodes() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) total += worker->nodes();
+    return total;
+}
+
+uint64_t Search::totalTbHits() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) total += worker->tbHits_.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Search::checkLimits() {
+    if ((limits_.nodes && totalNodes() >= limits_.nodes) || (hardLimitMs_ && elapsedMs() >= hardLimitMs_))
+        stop_.store(true, std::memory_order_relaxed);
+}
+
+int64_t Search::elapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start_).count();
+}
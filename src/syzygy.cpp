@@ -0,0 +1,778 @@
+#include "Syzygy.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <string_view>
+#include <system_error>
+
+// The file format is that of Ronald de Man's generator and probing code; the decoding below
+// follows the same steps. Tables are split by the file of the leading pawn (a to d, mirrored)
+// and, for WDL, by side to move. Each part is a "pairs" stream: values grouped by recursive
+// pairing into symbols, the symbols Huffman-coded in fixed-size blocks, with a sparse index
+// to find the block holding a given position index.
+namespace Syzygy {
+
+namespace {
+
+constexpr uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+constexpr uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+// Flags of one pairs stream.
+enum PairsFlag : uint8_t { STM = 1, MAPPED = 2, WIN_PLIES = 4, LOSS_PLIES = 8, WIDE = 16, SINGLE_VALUE = 128 };
+
+// How a probe went. CHANGE_STM: the DTZ table holds the other side to move.
+// ZEROING_BEST_MOVE: a capture or pawn move is best, so the table value is not needed.
+enum ProbeState { FAIL = 0, OK = 1, CHANGE_STM = -1, ZEROING_BEST_MOVE = 2 };
+
+// Root move ranks; above MAX_DTZ - 100 the win is certain within the fifty-move rule.
+constexpr int MAX_DTZ = 1 << 18;
+
+uint16_t readLE16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | p[1] << 8); }
+uint32_t readLE32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24; }
+uint32_t readBE32(const uint8_t* p) { return static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3]; }
+uint64_t readBE64(const uint8_t* p) { return static_cast<uint64_t>(readBE32(p)) << 32 | readBE32(p + 4); }
+
+int fileOf(int sq) { return sq & 7; }
+int rankOf(int sq) { return sq >> 3; }
+// Positive above the a1-h8 diagonal, zero on it.
+int offA1H8(int sq) { return rankOf(sq) - fileOf(sq); }
+int edgeDistance(int file) { return std::min(file, 7 - file); }
+int sign(int v) { return (v > 0) - (v < 0); }
+
+// Index tables of the position encoding, built once at startup.
+struct Encoding {
+    int mapA1D1D4[64] = {};   // a1-d1-d4 triangle to 0..9, diagonal squares last
+    int mapB1H1H7[64] = {};   // squares below the a1-h8 diagonal to 0..27
+    int mapKK[10][64] = {};   // the 462 placements of two kings, the first in the triangle
+    uint64_t binomial[7][64] = {};
+    int mapPawns[64] = {};    // a2-h7 to 47..0; the leading pawn has the highest value
+    int leadPawnIdx[6][64] = {};
+    int leadPawnsSize[6][4] = {};
+
+    Encoding() {
+        int code = 0;
+        for (int sq = 0; sq < 64; sq++)
+            if (offA1H8(sq) < 0) mapB1H1H7[sq] = code++;
+
+        code = 0;
+        int diagonal[4], diagonalCount = 0;
+        for (int sq = 0; sq <= 27; sq++) {
+            if (fileOf(sq) > 3) continue;
+            if (offA1H8(sq) < 0) mapA1D1D4[sq] = code++;
+            else if (offA1H8(sq) == 0) diagonal[diagonalCount++] = sq;
+        }
+        for (int i = 0; i < diagonalCount; i++) mapA1D1D4[diagonal[i]] = code++;
+
+        // Kings touching each other are left out; with the first king on the diagonal the
+        // second is mirrored below it, and both on the diagonal come last.
+        std::vector<std::pair<int, int>> bothOnDiagonal;
+        code = 0;
+        for (int idx = 0; idx < 10; idx++) {
+            for (int s1 = 0; s1 <= 27; s1++) {
+                if (fileOf(s1) > 3 || mapA1D1D4[s1] != idx || (idx == 0 && s1 != 1)) continue;
+                for (int s2 = 0; s2 < 64; s2++) {
+                    if (std::abs(fileOf(s1) - fileOf(s2)) <= 1 && std::abs(rankOf(s1) - rankOf(s2)) <= 1) continue;
+                    if (!offA1H8(s1) && offA1H8(s2) > 0) continue;
+                    if (!offA1H8(s1) && !offA1H8(s2)) bothOnDiagonal.emplace_back(idx, s2);
+                    else mapKK[idx][s2] = code++;
+                }
+            }
+        }
+        for (auto [idx, sq] : bothOnDiagonal) mapKK[idx][sq] = code++;
+
+        binomial[0][0] = 1;
+        for (int n = 1; n < 64; n++)
+            for (int k = 0; k < 7 && k <= n; k++)
+                binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+
+        // Each table part is indexed on its own, so the count restarts for every file.
+        int available = 47;
+        for (int leadPawns = 1; leadPawns <= 5; leadPawns++) {
+            for (int f = 0; f < 4; f++) {
+                int idx = 0;
+                for (int r = 1; r <= 6; r++) {
+                    int sq = r * 8 + f;
+                    if (leadPawns == 1) {
+                        mapPawns[sq] = available--;
+                        mapPawns[sq ^ 7] = available--;
+                    }
+                    leadPawnIdx[leadPawns][sq] = idx;
+                    idx += static_cast<int>(binomial[leadPawns - 1][mapPawns[sq]]);
+                }
+                leadPawnsSize[leadPawns][f] = idx;
+            }
+        }
+    }
+};
+
+const Encoding ENCODING;
+
+bool pawnsBefore(int a, int b) { return ENCODING.mapPawns[a] < ENCODING.mapPawns[b]; }
+
+} // namespace
+
+// One pairs stream: the decoder state and the piece order of one table part.
+struct PairsData {
+    uint8_t flags = 0;
+    size_t blockSize = 0;
+    size_t span = 0;                       // a sparse index entry every `span` positions
+    uint32_t blockCount = 0;
+    int maxSymLen = 0;
+    int minSymLen = 0;                     // the value itself for SINGLE_VALUE streams
+    const uint8_t* lowestSym = nullptr;    // LE16 per length: lowest symbol of that length
+    const uint8_t* btree = nullptr;        // 3 bytes per symbol: the pair it expands to
+    const uint8_t* blockLength = nullptr;  // LE16 per block: values stored, minus one
+    size_t blockLengthSize = 0;
+    const uint8_t* sparseIndex = nullptr;  // 6 bytes per entry: LE32 block, LE16 offset
+    size_t sparseIndexSize = 0;
+    const uint8_t* data = nullptr;         // the Huffman-coded blocks
+    std::vector<uint64_t> base64;          // lowest code of each length, left-aligned
+    std::vector<uint8_t> symlen;           // values covered by each symbol, minus one
+    uint8_t pieces[MAX_PIECES] = {};       // color << 3 | type, in encoding order
+    uint64_t groupIdx[MAX_PIECES + 1] = {};
+    int groupLen[MAX_PIECES + 1] = {};     // zero-terminated
+    uint16_t mapIdx[4] = {};               // DTZ value maps for win, loss, cursed win, blessed loss
+
+    int left(int sym) const { return (btree[3 * sym + 1] & 0xF) << 8 | btree[3 * sym]; }
+    int right(int sym) const { return btree[3 * sym + 2] << 4 | btree[3 * sym + 1] >> 4; }
+};
+
+struct Table {
+    std::string name;        // e.g. "KRPvKR"
+    bool dtz = false;
+    uint64_t key = 0;        // Board::materialKey() with the first side of the name white
+    uint64_t key2 = 0;       // and with it black
+    int pieceCount = 0;
+    bool hasPawns = false;
+    bool hasUniquePieces = false;
+    int pawnCount[2] = {};   // leading pawn color first
+
+    std::atomic<bool> ready{false};
+    MappedFile file;
+    PairsData items[2][4];   // [side to move][leading pawn file]
+    const uint8_t* map = nullptr;
+
+    PairsData& get(int stm, int file) { return items[dtz ? 0 : stm][hasPawns ? file : 0]; }
+};
+
+namespace {
+
+void setSymlen(PairsData& d, int sym, std::vector<bool>& visited) {
+    visited[sym] = true;
+    int right = d.right(sym);
+    if (right == 0xFFF) return;
+    int left = d.left(sym);
+    if (!visited[left]) setSymlen(d, left, visited);
+    if (!visited[right]) setSymlen(d, right, visited);
+    d.symlen[sym] = static_cast<uint8_t>(d.symlen[left] + d.symlen[right] + 1);
+}
+
+const uint8_t* setSizes(PairsData& d, const uint8_t* data) {
+    d.flags = *data++;
+    if (d.flags & SINGLE_VALUE) {
+        d.minSymLen = *data++;
+        return data;
+    }
+
+    const uint64_t tableSize = d.groupIdx[std::find(d.groupLen, d.groupLen + MAX_PIECES, 0) - d.groupLen];
+    d.blockSize = size_t{1} << *data++;
+    d.span = size_t{1} << *data++;
+    d.sparseIndexSize = static_cast<size_t>((tableSize + d.span - 1) / d.span);
+    const int padding = *data++;
+    d.blockCount = readLE32(data);
+    data += 4;
+    // Padded so that the sparse index never points past the end.
+    d.blockLengthSize = d.blockCount + padding;
+    d.maxSymLen = *data++;
+    d.minSymLen = *data++;
+    d.lowestSym = data;
+
+    // Canonical Huffman code: longer codes have lower values. base64[l] is the lowest code of
+    // length minSymLen + l, left-aligned in 64 bits, so a code's length is found by comparing
+    // the next 64 bits of input against it.
+    d.base64.assign(d.maxSymLen - d.minSymLen + 1, 0);
+    for (int i = static_cast<int>(d.base64.size()) - 2; i >= 0; i--)
+        d.base64[i] = (d.base64[i + 1] + readLE16(d.lowestSym + 2 * i) - readLE16(d.lowestSym + 2 * (i + 1))) / 2;
+    for (size_t i = 0; i < d.base64.size(); i++) d.base64[i] <<= 64 - i - d.minSymLen;
+
+    data += d.base64.size() * 2;
+    d.symlen.assign(readLE16(data), 0);
+    data += 2;
+    d.btree = data;
+
+    std::vector<bool> visited(d.symlen.size());
+    for (size_t sym = 0; sym < d.symlen.size(); sym++)
+        if (!visited[sym]) setSymlen(d, static_cast<int>(sym), visited);
+    return data + d.symlen.size() * 3 + (d.symlen.size() & 1);
+}
+
+// Split the pieces into groups encoded together: the leading group (kings and a third unique
+// piece, or the leading pawns), then runs of identical pieces. `order` says in which order
+// the groups are multiplied into the index.
+void setGroups(const Table& t, PairsData& d, const int order[2], int file) {
+    const Encoding& e = ENCODING;
+    int n = 0;
+    int firstLen = t.hasPawns ? 0 : t.hasUniquePieces ? 3 : 2;
+    d.groupLen[n] = 1;
+    for (int i = 1; i < t.pieceCount; i++) {
+        if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1]) d.groupLen[n]++;
+        else d.groupLen[++n] = 1;
+    }
+    d.groupLen[++n] = 0;
+
+    const bool pawnsBothSides = t.hasPawns && t.pawnCount[1];
+    int next = pawnsBothSides ? 2 : 1;
+    int freeSquares = 64 - d.groupLen[0] - (pawnsBothSides ? d.groupLen[1] : 0);
+    uint64_t idx = 1;
+    for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+        if (k == order[0]) {
+            d.groupIdx[0] = idx;
+            idx *= t.hasPawns ? e.leadPawnsSize[d.groupLen[0]][file] : t.hasUniquePieces ? 31332 : 462;
+        } else if (k == order[1]) {
+            d.groupIdx[1] = idx;
+            idx *= e.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+        } else {
+            d.groupIdx[next] = idx;
+            idx *= e.binomial[d.groupLen[next]][freeSquares];
+            freeSquares -= d.groupLen[next++];
+        }
+    }
+    d.groupIdx[n] = idx;
+}
+
+const uint8_t* setDtzMap(Table& t, const uint8_t* base, const uint8_t* data, int maxFile) {
+    t.map = data;
+    for (int f = 0; f <= maxFile; f++) {
+        PairsData& d = t.get(0, f);
+        if (!(d.flags & MAPPED)) continue;
+        if (d.flags & WIDE) {
+            data += (data - base) & 1;
+            for (int i = 0; i < 4; i++) {
+                d.mapIdx[i] = static_cast<uint16_t>((data - t.map) / 2 + 1);
+                data += 2 * readLE16(data) + 2;
+            }
+        } else {
+            for (int i = 0; i < 4; i++) {
+                d.mapIdx[i] = static_cast<uint16_t>(data - t.map + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    return data + ((data - base) & 1);
+}
+
+// Read the table header and locate every stream. False if the file does not fit the table.
+bool setup(Table& t, const uint8_t* base, size_t size) {
+    constexpr uint8_t SPLIT = 1, HAS_PAWNS = 2;
+    const uint8_t* data = base + 4;
+    if (static_cast<bool>(*data & HAS_PAWNS) != t.hasPawns || static_cast<bool>(*data & SPLIT) != (t.key != t.key2))
+        return false;
+    data++;
+
+    const int sides = !t.dtz && t.key != t.key2 ? 2 : 1;
+    const int maxFile = t.hasPawns ? 3 : 0;
+    const bool pawnsBothSides = t.hasPawns && t.pawnCount[1];
+
+    for (int f = 0; f <= maxFile; f++) {
+        for (int i = 0; i < sides; i++) t.items[i][f] = PairsData();
+        const int order[2][2] = {{data[0] & 0xF, pawnsBothSides ? data[1] & 0xF : 0xF},
+                                 {data[0] >> 4, pawnsBothSides ? data[1] >> 4 : 0xF}};
+        data += 1 + pawnsBothSides;
+        for (int k = 0; k < t.pieceCount; k++, data++)
+            for (int i = 0; i < sides; i++) t.items[i][f].pieces[k] = i ? *data >> 4 : *data & 0xF;
+        for (int i = 0; i < sides; i++) setGroups(t, t.items[i][f], order[i], f);
+    }
+    data += (data - base) & 1;
+
+    for (int f = 0; f <= maxFile; f++)
+        for (int i = 0; i < sides; i++) data = setSizes(t.items[i][f], data);
+    if (t.dtz) data = setDtzMap(t, base, data, maxFile);
+
+    for (int f = 0; f <= maxFile; f++)
+        for (int i = 0; i < sides; i++) {
+            t.items[i][f].sparseIndex = data;
+            data += t.items[i][f].sparseIndexSize * 6;
+        }
+    for (int f = 0; f <= maxFile; f++)
+        for (int i = 0; i < sides; i++) {
+            t.items[i][f].blockLength = data;
+            data += t.items[i][f].blockLengthSize * 2;
+        }
+    for (int f = 0; f <= maxFile; f++)
+        for (int i = 0; i < sides; i++) {
+            data = base + ((data - base + 63) & ~ptrdiff_t{63});
+            t.items[i][f].data = data;
+            data += static_cast<size_t>(t.items[i][f].blockCount) * t.items[i][f].blockSize;
+        }
+    return data <= base + size;
+}
+
+// The value stored at position index `idx`.
+int decompress(const PairsData& d, uint64_t idx) {
+    if (d.flags & SINGLE_VALUE) return d.minSymLen;
+
+    // The sparse index gives the block and offset of the middle of each span; walk from there
+    // to the block that holds `idx`.
+    const uint32_t k = static_cast<uint32_t>(idx / d.span);
+    uint32_t block = readLE32(d.sparseIndex + 6 * k);
+    int offset = readLE16(d.sparseIndex + 6 * k + 4);
+    offset += static_cast<int>(idx % d.span) - static_cast<int>(d.span / 2);
+    while (offset < 0) offset += readLE16(d.blockLength + 2 * --block) + 1;
+    while (offset > readLE16(d.blockLength + 2 * block)) offset -= readLE16(d.blockLength + 2 * block++) + 1;
+
+    // Decode symbols until the one covering `offset`.
+    const uint8_t* ptr = d.data + static_cast<size_t>(block) * d.blockSize;
+    uint64_t buf64 = readBE64(ptr);
+    ptr += 8;
+    int buf64Size = 64;
+    int sym;
+    while (true) {
+        int len = 0;
+        while (buf64 < d.base64[len]) len++;
+        sym = static_cast<int>((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+        sym += readLE16(d.lowestSym + 2 * len);
+        if (offset < d.symlen[sym] + 1) break;
+        offset -= d.symlen[sym] + 1;
+        len += d.minSymLen;
+        buf64 <<= len;
+        buf64Size -= len;
+        if (buf64Size <= 32) {
+            buf64Size += 32;
+            buf64 |= static_cast<uint64_t>(readBE32(ptr)) << (64 - buf64Size);
+            ptr += 4;
+        }
+    }
+
+    // Expand the symbol's pairs down to the single value at `offset`.
+    while (d.symlen[sym]) {
+        int left = d.left(sym);
+        if (offset < d.symlen[left] + 1) {
+            sym = left;
+        } else {
+            offset -= d.symlen[left] + 1;
+            sym = d.right(sym);
+        }
+    }
+    return d.left(sym);
+}
+
+// Table piece code: color << 3 | type, with white 0 and black 1.
+uint8_t tablePiece(PieceCode code) {
+    return static_cast<uint8_t>((code & 7) | (colorOf(code) == PieceColor::Black ? 8 : 0));
+}
+
+int mapScore(Table& t, int file, int value, Wdl wdl) {
+    if (!t.dtz) return value - 2;
+
+    constexpr int WDL_MAP[] = {1, 3, 0, 2, 0};
+    const PairsData& d = t.get(0, file);
+    if (d.flags & MAPPED) {
+        int idx = d.mapIdx[WDL_MAP[wdl + 2]] + value;
+        value = d.flags & WIDE ? readLE16(t.map + 2 * idx) : t.map[idx];
+    }
+    // Stored in moves unless the table says plies; cursed results always in moves.
+    if ((wdl == Win && !(d.flags & WIN_PLIES)) || (wdl == Loss && !(d.flags & LOSS_PLIES))
+        || wdl == CursedWin || wdl == BlessedLoss)
+        value *= 2;
+    return value + 1;
+}
+
+// Encode `board` as an index into `t` and decode the value there.
+int probeEntry(Table& t, const Board& board, Wdl wdl, int& state) {
+    const Encoding& e = ENCODING;
+    int squares[MAX_PIECES];
+    uint8_t pieces[MAX_PIECES];
+    int size = 0, leadPawnsCount = 0, tableFile = 0;
+    Bitboard leadPawns = 0;
+
+    // Tables are stored with the side named first as white; a symmetric table only for white
+    // to move. Otherwise colors are swapped and the board flipped vertically.
+    const bool blackToMove = board.getTurn() == PieceColor::Black;
+    const bool flip = (t.key == t.key2 && blackToMove) || board.materialKey() != t.key;
+    const int flipColor = flip ? 8 : 0;
+    const int flipSquares = flip ? 56 : 0;
+    const int stm = flip != blackToMove;
+
+    // Pawn tables are split by the file of the leading pawn, the one nearest the edge and
+    // lowest among those.
+    if (t.hasPawns) {
+        const uint8_t pawn = t.get(0, 0).pieces[0] ^ flipColor;
+        Bitboard b = leadPawns = board.pieces(PieceType::Pawn, pawn & 8 ? PieceColor::Black : PieceColor::White);
+        while (b) squares[size++] = popLsb(b) ^ flipSquares;
+        leadPawnsCount = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount, pawnsBefore));
+        tableFile = edgeDistance(fileOf(squares[0]));
+    }
+
+    // DTZ tables hold one side to move only.
+    if (t.dtz) {
+        const uint8_t flags = t.get(stm, tableFile).flags;
+        if ((flags & STM) != stm && !(t.key == t.key2 && !t.hasPawns)) {
+            state = CHANGE_STM;
+            return 0;
+        }
+    }
+
+    for (Bitboard b = board.occupied() ^ leadPawns; b;) {
+        Square sq = popLsb(b);
+        squares[size] = sq ^ flipSquares;
+        pieces[size++] = tablePiece(board.pieceOn(sq)) ^ flipColor;
+    }
+
+    PairsData& d = t.get(stm, tableFile);
+
+    // Put the pieces in the table's order.
+    for (int i = leadPawnsCount; i < size - 1; i++) {
+        for (int j = i + 1; j < size; j++) {
+            if (d.pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // Mirror so the leading piece is on files a-d.
+    if (fileOf(squares[0]) > 3)
+        for (int i = 0; i < size; i++) squares[i] ^= 7;
+
+    uint64_t idx;
+    if (t.hasPawns) {
+        idx = e.leadPawnIdx[leadPawnsCount][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnsCount, pawnsBefore);
+        for (int i = 1; i < leadPawnsCount; i++) idx += e.binomial[i][e.mapPawns[squares[i]]];
+    } else {
+        // Without pawns the board also mirrors vertically and along the a1-h8 diagonal, which
+        // brings the leading piece into the a1-d1-d4 triangle.
+        if (rankOf(squares[0]) > 3)
+            for (int i = 0; i < size; i++) squares[i] ^= 56;
+
+        for (int i = 0; i < d.groupLen[0]; i++) {
+            if (!offA1H8(squares[i])) continue;
+            if (offA1H8(squares[i]) > 0)
+                for (int j = i; j < size; j++) squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            break;
+        }
+
+        if (t.hasUniquePieces) {
+            // Three unique pieces encoded together: 63 squares for the second, 62 for the third.
+            const int adjust1 = squares[1] > squares[0];
+            const int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (offA1H8(squares[0]))
+                idx = (e.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            else if (offA1H8(squares[1]))
+                idx = (6 * 63 + rankOf(squares[0]) * 28 + e.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            else if (offA1H8(squares[2]))
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + rankOf(squares[0]) * 7 * 28
+                    + (rankOf(squares[1]) - adjust1) * 28 + e.mapB1H1H7[squares[2]];
+            else
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(squares[0]) * 7 * 6
+                    + (rankOf(squares[1]) - adjust1) * 6 + (rankOf(squares[2]) - adjust2);
+        } else {
+            idx = e.mapKK[e.mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // The other groups, each as a combination of the squares not taken by earlier groups.
+    idx *= d.groupIdx[0];
+    int* groupSq = squares + d.groupLen[0];
+    bool remainingPawns = t.hasPawns && t.pawnCount[1];
+    for (int next = 1; d.groupLen[next]; next++) {
+        std::stable_sort(groupSq, groupSq + d.groupLen[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d.groupLen[next]; i++) {
+            int adjust = static_cast<int>(std::count_if(squares, groupSq, [&](int sq) { return groupSq[i] > sq; }));
+            n += e.binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+        }
+        remainingPawns = false;
+        idx += n * d.groupIdx[next];
+        groupSq += d.groupLen[next];
+    }
+
+    return mapScore(t, tableFile, decompress(d, idx), wdl);
+}
+
+// DTZ of a position whose best move zeroes the counter: one ply to go.
+int dtzBeforeZeroing(Wdl wdl) {
+    switch (wdl) {
+    case Win: return 1;
+    case CursedWin: return 101;
+    case BlessedLoss: return -101;
+    case Loss: return -1;
+    default: return 0;
+    }
+}
+
+bool isMate(const Board& board) {
+    if (!board.checkers()) return false;
+    MoveList moves;
+    board.legalMoves(moves);
+    return moves.empty();
+}
+
+// Parse a table name such as "KRPvKR" into piece counts by side and type.
+bool parseName(const std::string& name, int counts[2][7]) {
+    constexpr std::string_view LETTERS = " PNBRQK";
+    int side = 0, total = 0;
+    for (char c : name) {
+        if (c == 'v') {
+            if (side++) return false;
+            continue;
+        }
+        size_t type = LETTERS.find(c);
+        if (type == std::string_view::npos || type == 0) return false;
+        counts[side][type]++;
+        total++;
+    }
+    return side == 1 && counts[0][6] == 1 && counts[1][6] == 1 && total <= MAX_PIECES;
+}
+
+// Board::materialKey() of a position with `white` and `black` piece counts.
+uint64_t materialKey(const int white[7], const int black[7]) {
+    uint64_t key = 0;
+    for (int t = 1; t <= 5; t++) {
+        key |= static_cast<uint64_t>(white[t]) << (Board::MATERIAL_BITS * (t - 1));
+        key |= static_cast<uint64_t>(black[t]) << (Board::MATERIAL_BITS * (5 + t - 1));
+    }
+    return key;
+}
+
+std::unique_ptr<Table> makeTable(const std::string& name, const int counts[2][7], bool dtz) {
+    auto t = std::make_unique<Table>();
+    t->name = name;
+    t->dtz = dtz;
+    t->key = materialKey(counts[0], counts[1]);
+    t->key2 = materialKey(counts[1], counts[0]);
+    for (int c = 0; c < 2; c++) {
+        for (int type = 1; type <= 6; type++) {
+            t->pieceCount += counts[c][type];
+            if (type < 6 && counts[c][type] == 1) t->hasUniquePieces = true;
+        }
+    }
+    const int whitePawns = counts[0][1], blackPawns = counts[1][1];
+    t->hasPawns = whitePawns + blackPawns > 0;
+    // The side with fewer pawns leads, which compresses better.
+    const bool whiteLeads = !blackPawns || (whitePawns && blackPawns >= whitePawns);
+    t->pawnCount[0] = whiteLeads ? whitePawns : blackPawns;
+    t->pawnCount[1] = whiteLeads ? blackPawns : whitePawns;
+    return t;
+}
+
+} // namespace
+
+Tablebases::Tablebases() = default;
+Tablebases::~Tablebases() = default;
+
+size_t Tablebases::init(const std::string& paths) {
+    byKey_.clear();
+    tables_.clear();
+    paths_.clear();
+    wdlCount_ = 0;
+    maxPieces_ = 0;
+
+    for (size_t begin = 0; begin <= paths.size();) {
+        size_t end = std::min(paths.find(':', begin), paths.size());
+        if (end > begin) paths_.push_back(paths.substr(begin, end - begin));
+        begin = end + 1;
+    }
+
+    namespace fs = std::filesystem;
+    for (const std::string& dir : paths_) {
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, ec), last; !ec && it != last; it.increment(ec)) {
+            const std::string file = it->path().filename().string();
+            if (file.size() <= 5 || file.compare(file.size() - 5, 5, ".rtbw") != 0) continue;
+            const std::string name = file.substr(0, file.size() - 5);
+            int counts[2][7] = {};
+            if (!parseName(name, counts)) continue;
+
+            auto wdl = makeTable(name, counts, false);
+            if (byKey_.count(wdl->key)) continue;
+            Table* dtz = nullptr;
+            for (const std::string& dtzDir : paths_) {
+                if (fs::exists(fs::path(dtzDir) / (name + ".rtbz"), ec)) {
+                    tables_.push_back(makeTable(name, counts, true));
+                    dtz = tables_.back().get();
+                    break;
+                }
+            }
+            byKey_[wdl->key] = {wdl.get(), dtz};
+            byKey_[wdl->key2] = {wdl.get(), dtz};
+            maxPieces_ = std::max(maxPieces_, wdl->pieceCount);
+            tables_.push_back(std::move(wdl));
+            wdlCount_++;
+        }
+    }
+    return wdlCount_;
+}
+
+bool Tablebases::map(Table& table) const {
+    if (table.ready.load(std::memory_order_acquire)) return table.file.isOpen();
+
+    std::lock_guard<std::mutex> lock(mapMutex_);
+    if (table.ready.load(std::memory_order_relaxed)) return table.file.isOpen();
+
+    const std::string file = table.name + (table.dtz ? ".rtbz" : ".rtbw");
+    const uint8_t* magic = table.dtz ? DTZ_MAGIC : WDL_MAGIC;
+    for (const std::string& dir : paths_) {
+        std::string error;
+        if (!table.file.open(dir + "/" + file, error)) continue;
+        const auto* base = reinterpret_cast<const uint8_t*>(table.file.data());
+        const size_t size = table.file.size();
+        // Files are padded to 64 bytes plus a 16-byte checksum at the end.
+        if (size % 64 != 16 || size < 64 || !std::equal(magic, magic + 4, base) || !setup(table, base, size))
+            table.file.close();
+        break;
+    }
+    table.ready.store(true, std::memory_order_release);
+    return table.file.isOpen();
+}
+
+int Tablebases::probeTable(const Board& board, bool dtz, Wdl wdl, int& state) const {
+    if (popcount(board.occupied()) == 2) return Draw;
+
+    auto it = byKey_.find(board.materialKey());
+    Table* table = it == byKey_.end() ? nullptr : dtz ? it->second.second : it->second.first;
+    if (!table || !map(*table)) {
+        state = FAIL;
+        return 0;
+    }
+    return probeEntry(*table, board, wdl, state);
+}
+
+Wdl Tablebases::search(Board& board, bool zeroingMoves, int& state) const {
+    MoveList moves;
+    board.legalMoves(moves);
+
+    Wdl best = Loss;
+    size_t searched = 0;
+    for (Move m : moves) {
+        if (!m.isCapture() && (!zeroingMoves || typeOf(board.pieceOn(m.from())) != PieceType::Pawn)) continue;
+        searched++;
+        board.makeMove(m);
+        Wdl value = static_cast<Wdl>(-search(board, false, state));
+        board.unmakeMove();
+        if (state == FAIL) return Draw;
+        if (value > best) {
+            best = value;
+            if (value >= Win) {
+                state = ZEROING_BEST_MOVE;
+                return value;
+            }
+        }
+    }
+
+    // When every move was tried the table is not needed; it may even be wrong, as it knows
+    // nothing of en passant.
+    const bool allSearched = searched && searched == moves.size();
+    Wdl value = best;
+    if (!allSearched) {
+        value = static_cast<Wdl>(probeTable(board, false, Draw, state));
+        if (state == FAIL) return Draw;
+    }
+
+    // The table may store anything where a capture is at least as good.
+    if (best >= value) {
+        state = best > Draw || allSearched ? ZEROING_BEST_MOVE : OK;
+        return best;
+    }
+    state = OK;
+    return value;
+}
+
+bool Tablebases::probeWdl(Board& board, Wdl& wdl) const {
+    if (!covers(board)) return false;
+    int state = OK;
+    wdl = search(board, false, state);
+    return state != FAIL;
+}
+
+int Tablebases::dtz(Board& board, int& state) const {
+    state = OK;
+    const Wdl wdl = search(board, true, state);
+    if (state == FAIL || wdl == Draw) return 0;
+    if (state == ZEROING_BEST_MOVE) return dtzBeforeZeroing(wdl);
+
+    int value = probeTable(board, true, wdl, state);
+    if (state == FAIL) return 0;
+    if (state != CHANGE_STM) return (value + 100 * (wdl == BlessedLoss || wdl == CursedWin)) * sign(wdl);
+
+    // The table is for the other side to move: take the best DTZ one ply further on.
+    MoveList moves;
+    board.legalMoves(moves);
+    int best = 0xFFFF;
+    for (Move m : moves) {
+        const bool zeroing = m.isCapture() || typeOf(board.pieceOn(m.from())) == PieceType::Pawn;
+        board.makeMove(m);
+        // After a zeroing move only the result matters; DTZ counts from before it.
+        int d = zeroing ? -dtzBeforeZeroing(search(board, false, state)) : -dtz(board, state);
+        if (d == 1 && isMate(board)) best = 1;
+        if (!zeroing) d += sign(d);
+        if (d < best && sign(d) == sign(wdl)) best = d;
+        board.unmakeMove();
+        if (state == FAIL) return 0;
+    }
+    return best == 0xFFFF ? -1 : best;
+}
+
+bool Tablebases::probeDtz(Board& board, int& dtzOut) const {
+    if (!covers(board)) return false;
+    int state = OK;
+    dtzOut = dtz(board, state);
+    return state != FAIL;
+}
+
+bool Tablebases::filterRootMoves(Board& board, MoveList& moves) const {
+    if (!covers(board) || moves.empty()) return false;
+
+    const int halfmoves = board.halfmoveClock();
+    const bool repeated = board.isRepetition();
+    int ranks[MAX_MOVES];
+    int state = OK;
+
+    // Rank by DTZ: wins that convert within the fifty-move rule are all equally good, and the
+    // closer the counter gets to 100 the more a quick conversion (or a long loss) counts.
+    for (size_t i = 0; i < moves.size() && state != FAIL; i++) {
+        board.makeMove(moves[i]);
+        int d;
+        if (board.halfmoveClock() == 0) {
+            d = dtzBeforeZeroing(static_cast<Wdl>(-search(board, false, state)));
+        } else if (board.halfmoveClock() >= 100 || board.isRepetition()) {
+            d = 0;
+        } else {
+            d = -dtz(board, state);
+            d += sign(d);
+        }
+        if (d == 2 && isMate(board)) d = 1;
+        board.unmakeMove();
+
+        ranks[i] = d > 0 ? (d + halfmoves <= 99 && !repeated ? MAX_DTZ : MAX_DTZ - (d + halfmoves))
+                 : d < 0 ? (-d * 2 + halfmoves < 100 ? -MAX_DTZ : -MAX_DTZ + (-d + halfmoves))
+                 : 0;
+    }
+
+    // Without DTZ tables, by WDL alone.
+    if (state == FAIL) {
+        constexpr int WDL_RANK[] = {-MAX_DTZ, -MAX_DTZ + 101, 0, MAX_DTZ - 101, MAX_DTZ};
+        for (size_t i = 0; i < moves.size(); i++) {
+            board.makeMove(moves[i]);
+            state = OK;
+            Wdl wdl = static_cast<Wdl>(-search(board, false, state));
+            board.unmakeMove();
+            if (state == FAIL) return false;
+            ranks[i] = WDL_RANK[wdl + 2];
+        }
+    }
+
+    const int best = *std::max_element(ranks, ranks + moves.size());
+    MoveList kept;
+    for (size_t i = 0; i < moves.size(); i++)
+        if (ranks[i] == best) kept.push_back(moves[i]);
+    moves = kept;
+    return true;
+}
+
+} // namespace Syzygy
@@ -0,0 +1,159 @@
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Allocate `bytes` aligned to `alignment` (a power of two that divides `bytes`).
+void* alignedAlloc(size_t alignment, size_t bytes) {
+#ifdef _WIN32
+    return _aligned_malloc(bytes, alignment);
+#else
+    return std::aligned_alloc(alignment, bytes);
+#endif
+}
+
+void alignedFree(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+void TranspositionTable::release() {
+    if (buckets_) alignedFree(buckets_);
+    buckets_ = nullptr;
+    bucketCount_ = 0;
+    allocatedBytes_ = 0;
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    release();
+
+    size_t bytes = std::max<size_t>(megabytes, 1) * 1024 * 1024;
+    // Tables of at least one huge page are allocated on a huge page boundary so the kernel can
+    // back them with 2 MB pages, which cuts TLB misses on random probes substantially.
+    size_t alignment = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : alignof(Bucket);
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+
+    void* mem = alignedAlloc(alignment, bytes);
+    if (!mem) throw std::bad_alloc();
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (alignment == HUGE_PAGE_SIZE) madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+
+    buckets_ = static_cast<Bucket*>(mem);
+    bucketCount_ = bytes / sizeof(Bucket);
+    allocatedBytes_ = bytes;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    // Entries are pairs of lock-free atomics, which have the same representation as plain words.
+    std::memset(static_cast<void*>(buckets_), 0, allocatedBytes_);
+    generation_ = 0;
+}
+
+uint64_t TranspositionTable::pack(Move move, int score, int eval, int depth, Bound bound, uint8_t generation) {
+    return static_cast<uint64_t>(move.raw())
+         | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16
+         | static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32
+         | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48
+         | static_cast<uint64_t>(bound) << 56
+         | static_cast<uint64_t>(generation) << 58;
+}
+
+TTData TranspositionTable::unpack(uint64_t data) {
+    TTData d;
+    d.move = Move::fromRaw(static_cast<uint16_t>(data));
+    d.score = static_cast<int16_t>(data >> 16);
+    d.eval = static_cast<int16_t>(data >> 32);
+    d.depth = depthOf(data);
+    d.bound = static_cast<Bound>((data >> 56) & 3);
+    return d;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& out) const {
+    const Bucket& bucket = buckets_[bucketIndex(key)];
+    for (const Entry& e : bucket.entries) {
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.keyXorData.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && data) {
+            out = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, Bound bound, int score, int eval, Move move) {
+    Bucket& bucket = buckets_[bucketIndex(key)];
+
+    // Replace the entry for the same position if there is one, otherwise the entry that is
+    // least valuable: shallow and from an old search.
+    Entry* victim = nullptr;
+    uint64_t victimData = 0;
+    int victimWorth = 0;
+    bool samePosition = false;
+    for (Entry& e : bucket.entries) {
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.keyXorData.load(std::memory_order_relaxed);
+        if ((check ^ data) == key) {
+            victim = &e;
+            victimData = data;
+            samePosition = true;
+            break;
+        }
+        int age = (generation_ - generationOf(data)) & GENERATION_MASK;
+        int worth = depthOf(data) - 8 * age;
+        if (!victim || worth < victimWorth) {
+            victim = &e;
+            victimData = data;
+            victimWorth = worth;
+        }
+    }
+
+    if (samePosition) {
+        TTData old = unpack(victimData);
+        // Keep the old best move when the new result has none.
+        if (move.isNull()) move = old.move;
+        // Don't overwrite a much deeper result for the same position unless it is exact.
+        if (bound != Bound::Exact && old.depth > depth + 4 && generationOf(victimData) == generation_) return;
+    }
+
+    uint64_t data = pack(move, score, eval, depth, bound, generation_);
+    victim->data.store(data, std::memory_order_relaxed);
+    victim->keyXorData.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    size_t samples = std::min<size_t>(1000 / ENTRIES_PER_BUCKET, bucketCount_);
+    for (size_t i = 0; i < samples; i++) {
+        for (const Entry& e : buckets_[i].entries) {
+            uint64_t data = e.data.load(std::memory_order_relaxed);
+            if (data && generationOf(data) == generation_) used++;
+        }
+    }
+    return samples ? static_cast<int>(used * 1000 / (samples * ENTRIES_PER_BUCKET)) : 0;
+}
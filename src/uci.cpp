@@ -0,0 +1,209 @@
+#include "Uci.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ostream>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// The legal move written as `text` in UCI notation, or a null move.
+Move parseMove(const Board& board, const std::string& text) {
+    MoveList moves;
+    board.legalMoves(moves);
+    for (Move m : moves)
+        if (toUci(m) == text) return m;
+    return Move{};
+}
+
+} // namespace
+
+UciEngine::UciEngine(std::ostream& out)
+: out_(out)
+, tt_(DEFAULT_HASH_MB)
+, search_(tt_)
+, board_(PieceColor::White, START_FEN)
+{
+    search_.onInfo = [this](const SearchInfo& info) { send(formatInfo(info)); };
+}
+
+UciEngine::~UciEngine() {
+    stopSearch();
+}
+
+void UciEngine::loop(std::istream& in) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!execute(line)) return;
+    }
+}
+
+bool UciEngine::execute(const std::string& line) {
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if (command == "uci") {
+        uci();
+    } else if (command == "isready") {
+        send("readyok");
+    } else if (command == "setoption") {
+        setOption(args);
+    } else if (command == "ucinewgame") {
+        stopSearch();
+        tt_.clear();
+    } else if (command == "position") {
+        position(args);
+    } else if (command == "go") {
+        go(args);
+    } else if (command == "stop") {
+        stopSearch();
+    } else if (command == "quit") {
+        stopSearch();
+        return false;
+    } else if (command == "d") {
+        send(board_.toString() + "Fen: " + board_.toFEN());
+    } else if (!command.empty()) {
+        send("info string unknown command " + command);
+    }
+    return true;
+}
+
+void UciEngine::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outMutex_);
+    out_ << line << std::endl;
+}
+
+void UciEngine::uci() {
+    send("id name ChessCpp");
+    send("id author ChessCpp developers");
+    send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) + " min 1 max " + std::to_string(MAX_HASH_MB));
+    send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+    send("option name EvalFile type string default <empty>");
+    send("option name OwnBook type check default false");
+    send("option name BookFile type string default <empty>");
+    send("option name SyzygyPath type string default <empty>");
+    send("uciok");
+}
+
+void UciEngine::setOption(std::istringstream& args) {
+    // setoption name <name> [value <value>]; names may contain spaces.
+    std::string token, name, value;
+    args >> token;
+    while (args >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    std::getline(args >> std::ws, value);
+
+    stopSearch();
+    if (name == "Hash") {
+        tt_.resize(std::clamp(std::atoi(value.c_str()), 1, MAX_HASH_MB));
+    } else if (name == "Threads") {
+        search_.setThreads(std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS));
+    } else if (name == "EvalFile") {
+        if (value.empty() || value == "<empty>") {
+            search_.setNetwork(nullptr);
+            return;
+        }
+        std::string error;
+        if (network_.load(value, error)) {
+            search_.setNetwork(&network_);
+            send("info string loaded network " + value + " (" + Nnue::isaName(network_.isa()) + ")");
+        } else {
+            search_.setNetwork(nullptr);
+            send("info string " + error);
+        }
+    } else if (name == "OwnBook") {
+        ownBook_ = value == "true";
+    } else if (name == "BookFile") {
+        if (value.empty() || value == "<empty>") {
+            book_.close();
+            return;
+        }
+        std::string error;
+        send("info string " + (book_.open(value, error) ? "loaded " + value : error));
+    } else if (name == "SyzygyPath") {
+        size_t count = tablebases_.init(value == "<empty>" ? std::string() : value);
+        search_.setTablebases(count ? &tablebases_ : nullptr);
+        send("info string found " + std::to_string(count) + " tablebases"
+             + (count ? " up to " + std::to_string(tablebases_.maxPieces()) + " pieces" : std::string()));
+    } else {
+        send("info string unknown option " + name);
+    }
+}
+
+void UciEngine::position(std::istringstream& args) {
+    std::string token, fen;
+    args >> token;
+    if (token == "startpos") {
+        fen = START_FEN;
+        args >> token;
+    } else if (token == "fen") {
+        while (args >> token && token != "moves") fen += (fen.empty() ? "" : " ") + token;
+    } else {
+        return;
+    }
+
+    stopSearch();
+    FenError error;
+    if (!board_.setFEN(fen, &error)) {
+        send("info string invalid fen at offset " + std::to_string(error.offset) + ": " + error.message);
+        return;
+    }
+    if (token != "moves") return;
+    while (args >> token) {
+        Move m = parseMove(board_, token);
+        if (m.isNull()) {
+            send("info string illegal move " + token);
+            return;
+        }
+        board_.makeMove(m);
+    }
+}
+
+void UciEngine::go(std::istringstream& args) {
+    SearchLimits limits;
+    std::string token;
+    while (args >> token) {
+        if (token == "infinite") limits.infinite = true;
+        else if (token == "depth") args >> limits.depth;
+        else if (token == "nodes") args >> limits.nodes;
+        else if (token == "movetime") args >> limits.movetime;
+        else if (token == "wtime") args >> limits.time[0];
+        else if (token == "btime") args >> limits.time[1];
+        else if (token == "winc") args >> limits.increment[0];
+        else if (token == "binc") args >> limits.increment[1];
+        else if (token == "movestogo") args >> limits.movestogo;
+    }
+
+    stopSearch();
+    if (ownBook_ && !limits.infinite) {
+        Move bookMove = book_.pick(board_, Polyglot::Pick::Weighted, random_());
+        if (!bookMove.isNull()) {
+            send("bestmove " + toUci(bookMove));
+            return;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopRequested_ = false;
+    }
+    search_.start(board_, limits, [this, infinite = limits.infinite](const SearchResult& result) {
+        if (infinite) {
+            std::unique_lock<std::mutex> lock(stopMutex_);
+            stopCv_.wait(lock, [this] { return stopRequested_; });
+        }
+        std::string line = "bestmove " + (result.bestMove.isNull() ? std::string("0000") : toUci(result.bestMove));
+        if (!result.ponderMove.isNull()) line += " ponder " + toUci(result.ponderMove);
+        send(line);
+    });
+}
+
+void UciEngine::stopSearch() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopRequested_ = true;
+    }
+    stopCv_.notify_all();
+    search_.stop();
+    search_.wait();
+}
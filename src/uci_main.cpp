@@ -0,0 +1,10 @@
+#include "Uci.h"
+
+#include <iostream>
+
+int main() {
+    std::ios::sync_with_stdio(false);
+    UciEngine engine(std::cout);
+    engine.loop(std::cin);
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "Zobrist.h"
+
+namespace Zobrist {
+
+uint64_t PieceSquare[PIECE_CODE_NB][64];
+uint64_t SideToMove;
+uint64_t Castling[16];
+uint64_t EnPassantFile[8];
+
+namespace {
+
+// splitmix64; a fixed seed keeps keys identical between runs and builds.
+class KeyGenerator {
+public:
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t state_ = 1070372;
+};
+
+struct Initializer {
+    Initializer() { init(); }
+} initializer;
+
+} // namespace
+
+void init() {
+    KeyGenerator gen;
+    for (int code = 0; code < PIECE_CODE_NB; code++) {
+        int type = code & 7;
+        bool realPiece = type >= 1 && type <= 6 && colorOf(code) != PieceColor::None;
+        for (Square sq = 0; sq < 64; sq++) PieceSquare[code][sq] = realPiece ? gen.next() : 0;
+    }
+    SideToMove = gen.next();
+
+    // Each right gets a key; a mask's key is the XOR of its rights' keys.
+    uint64_t rights[4];
+    for (auto& r : rights) r = gen.next();
+    for (int mask = 0; mask < 16; mask++) {
+        Castling[mask] = 0;
+        for (int bit = 0; bit < 4; bit++)
+            if (mask & (1 << bit)) Castling[mask] ^= rights[bit];
+    }
+
+    for (auto& k : EnPassantFile) k = gen.next();
+}
+
+} // namespace Zobrist